@@ -0,0 +1,354 @@
+// Pipeline benchmark on procedural inputs built in memory: spheres, tori, terrain
+// heightfields, dense triangle soups and textured planes at several sizes, run
+// through Voxelizer, BlockOptimizer, JsonExporter and ObjGenerator.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cxxopts.hpp>
+#include <nlohmann/json.hpp>
+#include "mesh_processor.h"
+#include "voxelizer.h"
+#include "block_optimizer.h"
+#include "json_exporter.h"
+#include "ObjGenerator.h"
+
+using namespace obj2blocks;
+
+namespace {
+    constexpr double kPi = 3.14159265358979323846;
+
+    // Swallows the pipeline's progress output while stages are timed
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+    };
+
+    // Quad whose UV indices equal its vertex indices when it carries a material
+    void addQuad(ObjLoader&loader, int a, int b, int c, int d, const std::string&material) {
+        FaceData face;
+        face.vertex_indices = {a, b, c, d};
+        if (!material.empty()) {
+            face.uv_indices = face.vertex_indices;
+            face.material_name = material;
+        }
+        loader.addFace(face);
+    }
+
+    // Grid of (rows + 1) x (cols + 1) vertices from position(u, v), u and v in [0, 1]
+    std::unique_ptr<ObjLoader> makeGrid(int rows, int cols, const std::function<pmp::Point(double, double)>&position,
+                                        bool wrap_u = false, bool wrap_v = false, const std::string&material = "") {
+        auto loader = std::make_unique<ObjLoader>();
+        for (int i = 0; i <= rows; ++i) {
+            for (int j = 0; j <= cols; ++j) {
+                loader->addVertex(position(static_cast<double>(i) / rows, static_cast<double>(j) / cols));
+            }
+        }
+        auto index = [&](int i, int j) {
+            if (wrap_u) i %= rows;
+            if (wrap_v) j %= cols;
+            return i * (cols + 1) + j;
+        };
+        for (int i = 0; i < rows; ++i) {
+            for (int j = 0; j < cols; ++j) {
+                addQuad(*loader, index(i, j), index(i + 1, j), index(i + 1, j + 1), index(i, j + 1), material);
+            }
+        }
+        return loader;
+    }
+
+    std::unique_ptr<ObjLoader> makeSphere(int resolution) {
+        return makeGrid(resolution, 2 * resolution, [](double u, double v) {
+            double theta = u * kPi;
+            double phi = v * 2.0 * kPi;
+            return pmp::Point(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+        }, false, true);
+    }
+
+    std::unique_ptr<ObjLoader> makeTorus(int resolution) {
+        return makeGrid(2 * resolution, resolution, [](double u, double v) {
+            double theta = u * 2.0 * kPi;
+            double phi = v * 2.0 * kPi;
+            double ring = 1.0 + 0.35 * std::cos(phi);
+            return pmp::Point(ring * std::cos(theta), 0.35 * std::sin(phi), ring * std::sin(theta));
+        }, true, true);
+    }
+
+    std::unique_ptr<ObjLoader> makeTerrain(int resolution) {
+        return makeGrid(resolution, resolution, [](double u, double v) {
+            double height = 0.08 * std::sin(u * 9.0) * std::cos(v * 7.0) + 0.04 * std::sin(u * 23.0 + v * 17.0)
+                            + 0.15 * std::exp(-20.0 * ((u - 0.4) * (u - 0.4) + (v - 0.6) * (v - 0.6)));
+            return pmp::Point(u, height, v);
+        });
+    }
+
+    std::unique_ptr<ObjLoader> makeTriangleSoup(size_t triangles) {
+        auto loader = std::make_unique<ObjLoader>();
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> center(0.0f, 1.0f);
+        std::uniform_real_distribution<float> offset(-0.04f, 0.04f);
+        for (size_t t = 0; t < triangles; ++t) {
+            pmp::Point c(center(rng), center(rng), center(rng));
+            FaceData face;
+            for (int k = 0; k < 3; ++k) {
+                face.vertex_indices.push_back(static_cast<int>(3 * t + k));
+                loader->addVertex(c + pmp::Point(offset(rng), offset(rng), offset(rng)));
+            }
+            loader->addFace(face);
+        }
+        return loader;
+    }
+
+    // Slightly bent plane carrying a procedural RGB texture through a material
+    std::unique_ptr<ObjLoader> makeTexturedPlane(int resolution, int texture_size) {
+        auto loader = makeGrid(resolution, resolution, [](double u, double v) {
+            return pmp::Point(u, 0.1 * std::sin(u * kPi), v);
+        }, false, false, "plane");
+        for (int i = 0; i <= resolution; ++i) {
+            for (int j = 0; j <= resolution; ++j) {
+                loader->addUV(Vec2f(static_cast<float>(i) / resolution, static_cast<float>(j) / resolution));
+            }
+        }
+
+        auto texture = std::make_shared<TextureData>();
+        texture->width = texture_size;
+        texture->height = texture_size;
+        texture->channels = 3;
+        texture->data.resize(static_cast<size_t>(texture_size) * texture_size * 3);
+        for (int y = 0; y < texture_size; ++y) {
+            for (int x = 0; x < texture_size; ++x) {
+                uint8_t* texel = &texture->data[(static_cast<size_t>(y) * texture_size + x) * 3];
+                texel[0] = static_cast<uint8_t>(x * 255 / texture_size);
+                texel[1] = static_cast<uint8_t>(y * 255 / texture_size);
+                texel[2] = ((x / 16 + y / 16) & 1) ? 200 : 40;
+            }
+        }
+
+        Material material;
+        material.name = "plane";
+        material.diffuse_texture_path = "procedural";
+        material.textures[material.diffuse_texture_path] = texture;
+        loader->getMaterialLoader().addMaterial(material);
+        return loader;
+    }
+
+    struct Scene {
+        std::string name;
+        bool textured;
+        std::function<std::unique_ptr<ObjLoader>(int)> build;
+    };
+
+    struct CaseResult {
+        std::string scene;
+        int size = 0;
+        size_t triangles = 0;
+        size_t voxels = 0;
+        size_t commands = 0;
+        size_t json_bytes = 0;
+        double voxelize_seconds = 0.0;
+        double optimize_seconds = 0.0;
+        double json_seconds = 0.0;
+        double obj_seconds = 0.0;
+    };
+
+    // Median wall time of `repeats` runs of body
+    double timeMedian(int repeats, const std::function<void()>&body) {
+        std::vector<double> samples;
+        for (int r = 0; r < repeats; ++r) {
+            auto start = std::chrono::steady_clock::now();
+            body();
+            samples.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::sort(samples.begin(), samples.end());
+        return samples[samples.size() / 2];
+    }
+
+    double perSecond(size_t count, double seconds) {
+        return seconds > 0.0 ? count / seconds : 0.0;
+    }
+
+    bool runCase(const Scene&scene, int size, int repeats, bool optimize, const std::filesystem::path&scratch,
+                 CaseResult&result) {
+        result.scene = scene.name;
+        result.size = size;
+
+        MeshProcessor processor;
+        if (!processor.loadFromLoader(scene.build(size))) {
+            return false;
+        }
+        processor.centerMesh();
+        processor.autoScale(size);
+        result.triangles = processor.getMesh().n_faces();
+
+        Voxelizer voxelizer(1.0);
+        std::set<VoxelData> colored_voxels;
+        std::set<Vec3i> voxels;
+        result.voxelize_seconds = timeMedian(repeats, [&]() {
+            if (scene.textured) {
+                colored_voxels = voxelizer.voxelizeWithMaterials(processor, false);
+            } else {
+                voxels = voxelizer.voxelize(processor.getMesh(), false);
+            }
+        });
+        result.voxels = scene.textured ? colored_voxels.size() : voxels.size();
+
+        BlockOptimizer optimizer;
+        optimizer.setOptimizationEnabled(optimize);
+        std::vector<MinecraftCommand> commands;
+        result.optimize_seconds = timeMedian(repeats, [&]() {
+            commands = scene.textured ? optimizer.optimizeWithColors(colored_voxels) : optimizer.optimize(voxels);
+        });
+        result.commands = commands.size();
+
+        ConversionParams params;
+        params.target_size = size;
+        params.optimize = optimize;
+        params.with_texture = scene.textured;
+        result.json_seconds = timeMedian(repeats, [&]() {
+            JsonExporter exporter;
+            std::ostringstream out;
+            exporter.writeDocument(out, exporter.createJson(commands, params));
+            result.json_bytes = out.str().size();
+        });
+
+        std::string obj_file = (scratch / (scene.name + "_" + std::to_string(size) + ".obj")).string();
+        result.obj_seconds = timeMedian(repeats, [&]() {
+            ObjGenerator generator;
+            for (const auto&command: commands) {
+                generator.processCommand(command);
+            }
+            generator.writeToFile(obj_file);
+        });
+        return true;
+    }
+
+    std::vector<int> parseSizes(const std::string&list) {
+        std::vector<int> sizes;
+        std::istringstream iss(list);
+        std::string item;
+        while (std::getline(iss, item, ',')) {
+            if (!item.empty()) sizes.push_back(std::max(4, std::stoi(item)));
+        }
+        return sizes;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    cxxopts::Options options("obj2blocks_bench", "Voxelize/optimize/export benchmark on procedural meshes");
+    options.add_options()
+            ("s,sizes", "Comma-separated target sizes in voxels", cxxopts::value<std::string>()->default_value("32,64,128"))
+            ("scenes", "Comma-separated subset of sphere,torus,terrain,soup,textured-plane", cxxopts::value<std::string>()->default_value(""))
+            ("r,repeats", "Repetitions per stage (median is reported)", cxxopts::value<int>()->default_value("3"))
+            ("no-optimize", "Benchmark the optimizer with fillarea merging disabled", cxxopts::value<bool>()->default_value("false"))
+            ("json", "Also write the results to this JSON file", cxxopts::value<std::string>())
+            ("h,help", "Show this help message");
+
+    std::vector<int> sizes;
+    std::string scene_filter, json_file;
+    int repeats;
+    bool optimize = true;
+    try {
+        auto result = options.parse(argc, argv);
+        if (result.count("help")) {
+            std::cout << options.help() << std::endl;
+            return 0;
+        }
+        sizes = parseSizes(result["sizes"].as<std::string>());
+        scene_filter = result["scenes"].as<std::string>();
+        repeats = std::max(1, result["repeats"].as<int>());
+        if (result.count("no-optimize")) {
+            optimize = !result["no-optimize"].as<bool>();
+        }
+        if (result.count("json")) {
+            json_file = result["json"].as<std::string>();
+        }
+    }
+    catch (const std::exception&e) {
+        std::cerr << "Error parsing options: " << e.what() << "\n\n";
+        std::cout << options.help() << std::endl;
+        return 1;
+    }
+
+    // Mesh resolution grows with the target size so triangle and voxel counts scale together
+    const std::vector<Scene> scenes = {
+        {"sphere", false, [](int size) { return makeSphere(size); }},
+        {"torus", false, [](int size) { return makeTorus(size); }},
+        {"terrain", false, [](int size) { return makeTerrain(size); }},
+        {"soup", false, [](int size) { return makeTriangleSoup(static_cast<size_t>(size) * size * 4); }},
+        {"textured-plane", true, [](int size) { return makeTexturedPlane(std::max(2, size / 4), 1024); }},
+    };
+
+    std::filesystem::path scratch = std::filesystem::temp_directory_path() / "obj2blocks_bench";
+    std::filesystem::create_directories(scratch);
+
+    std::cout << std::left << std::setw(16) << "scene" << std::right << std::setw(6) << "size"
+              << std::setw(10) << "tris" << std::setw(10) << "voxels" << std::setw(10) << "commands"
+              << std::setw(14) << "tris/s" << std::setw(14) << "voxels/s" << std::setw(14) << "opt vox/s"
+              << std::setw(14) << "json cmd/s" << std::setw(14) << "obj cmd/s" << "\n";
+
+    nlohmann::json report = nlohmann::json::array();
+    bool ok = true;
+    for (const auto&scene: scenes) {
+        if (!scene_filter.empty() && ("," + scene_filter + ",").find("," + scene.name + ",") == std::string::npos) {
+            continue;
+        }
+        for (int size: sizes) {
+            CaseResult r;
+            NullBuffer null_buffer;
+            std::streambuf* console = std::cout.rdbuf(&null_buffer);
+            bool success = runCase(scene, size, repeats, optimize, scratch, r);
+            std::cout.rdbuf(console);
+            if (!success) {
+                std::cerr << "Error: " << scene.name << " at size " << size << " produced no mesh" << std::endl;
+                ok = false;
+                continue;
+            }
+
+            std::cout << std::left << std::setw(16) << r.scene << std::right << std::setw(6) << r.size
+                      << std::setw(10) << r.triangles << std::setw(10) << r.voxels << std::setw(10) << r.commands
+                      << std::fixed << std::setprecision(0)
+                      << std::setw(14) << perSecond(r.triangles, r.voxelize_seconds)
+                      << std::setw(14) << perSecond(r.voxels, r.voxelize_seconds)
+                      << std::setw(14) << perSecond(r.voxels, r.optimize_seconds)
+                      << std::setw(14) << perSecond(r.commands, r.json_seconds)
+                      << std::setw(14) << perSecond(r.commands, r.obj_seconds)
+                      << std::defaultfloat << std::endl;
+
+            report.push_back({
+                {"scene", r.scene}, {"size", r.size}, {"triangles", r.triangles}, {"voxels", r.voxels},
+                {"commands", r.commands}, {"json_bytes", r.json_bytes},
+                {"voxelize_seconds", r.voxelize_seconds}, {"optimize_seconds", r.optimize_seconds},
+                {"json_seconds", r.json_seconds}, {"obj_seconds", r.obj_seconds},
+                {"triangles_per_second", perSecond(r.triangles, r.voxelize_seconds)},
+                {"voxels_per_second", perSecond(r.voxels, r.voxelize_seconds)},
+                {"optimize_voxels_per_second", perSecond(r.voxels, r.optimize_seconds)},
+                {"json_commands_per_second", perSecond(r.commands, r.json_seconds)},
+                {"obj_commands_per_second", perSecond(r.commands, r.obj_seconds)}
+            });
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(scratch, ec);
+
+    if (!json_file.empty()) {
+        std::ofstream file(json_file);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open " << json_file << std::endl;
+            return 1;
+        }
+        nlohmann::json document = {{"repeats", repeats}, {"optimize", optimize}, {"cases", report}};
+        file << document.dump(2) << '\n';
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+// Texture sampling microbenchmark: row-major vs tiled layout under the UV access
+// pattern the voxelizer produces (a voxel walk over a textured plane) and random UVs.
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <cxxopts.hpp>
+#include "material_sampler.h"
+#include "texture_cache.h"
+
+using namespace obj2blocks;
+
+namespace {
+    TextureData makeTexture(int size, int channels) {
+        TextureData texture;
+        texture.width = size;
+        texture.height = size;
+        texture.channels = channels;
+        texture.data.resize(static_cast<size_t>(size) * size * channels);
+        std::mt19937 rng(42);
+        for (auto&byte : texture.data) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        return texture;
+    }
+
+    // UVs in voxel traversal order: x/y/z loops over a block mapped through a rotated
+    // plane, moving `texels_per_voxel` texels per voxel step
+    std::vector<std::pair<float, float>> voxelWalkUVs(size_t count, int size, float texels_per_voxel) {
+        std::vector<std::pair<float, float>> uvs;
+        uvs.reserve(count);
+        const float step = texels_per_voxel / static_cast<float>(size);
+        const float angle = 0.7f;
+        const float du[3] = {std::cos(angle) * step, 0.3f * step, std::sin(angle) * step};
+        const float dv[3] = {-std::sin(angle) * step, 0.9f * step, std::cos(angle) * step};
+        const int extent = 128;
+        while (uvs.size() < count) {
+            for (int x = 0; x < extent && uvs.size() < count; ++x) {
+                for (int y = 0; y < extent && uvs.size() < count; ++y) {
+                    for (int z = 0; z < extent && uvs.size() < count; ++z) {
+                        uvs.emplace_back(x * du[0] + y * du[1] + z * du[2], x * dv[0] + y * dv[1] + z * dv[2]);
+                    }
+                }
+            }
+        }
+        return uvs;
+    }
+
+    std::vector<std::pair<float, float>> randomUVs(size_t count) {
+        std::vector<std::pair<float, float>> uvs(count);
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+        for (auto&uv : uvs) {
+            uv = {dist(rng), dist(rng)};
+        }
+        return uvs;
+    }
+
+    struct Result {
+        double ns_per_sample;
+        uint64_t checksum;
+    };
+
+    Result run(const TextureData&texture, const std::vector<std::pair<float, float>>&uvs, int repeats) {
+        uint64_t checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; ++r) {
+            for (const auto&[u, v] : uvs) {
+                Color4 c = MaterialSampler::sampleTexture(texture, u, v);
+                checksum += c.r + (c.g << 8) + (c.b << 16) + (static_cast<uint64_t>(c.a) << 24);
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return {seconds * 1e9 / (static_cast<double>(uvs.size()) * repeats), checksum};
+    }
+}
+
+int main(int argc, char* argv[]) {
+    cxxopts::Options options("texture_sampling_bench", "Texture layout sampling microbenchmark");
+    options.add_options()
+            ("s,size", "Texture width and height", cxxopts::value<int>()->default_value("8192"))
+            ("c,channels", "Source channels (1-4)", cxxopts::value<int>()->default_value("3"))
+            ("n,samples", "Samples per pattern", cxxopts::value<size_t>()->default_value("4000000"))
+            ("t,texels-per-voxel", "Texels advanced per voxel step in the walk pattern", cxxopts::value<float>()->default_value("2"))
+            ("r,repeats", "Repetitions", cxxopts::value<int>()->default_value("3"))
+            ("h,help", "Show this help message");
+
+    int size, channels, repeats;
+    size_t samples;
+    float texels_per_voxel;
+    try {
+        auto result = options.parse(argc, argv);
+        if (result.count("help")) {
+            std::cout << options.help() << std::endl;
+            return 0;
+        }
+        size = result["size"].as<int>();
+        channels = std::clamp(result["channels"].as<int>(), 1, 4);
+        samples = result["samples"].as<size_t>();
+        texels_per_voxel = result["texels-per-voxel"].as<float>();
+        repeats = std::max(1, result["repeats"].as<int>());
+    }
+    catch (const cxxopts::exceptions::exception&e) {
+        std::cerr << "Error parsing options: " << e.what() << "\n\n";
+        std::cout << options.help() << std::endl;
+        return 1;
+    }
+
+    TextureData row_major = makeTexture(size, channels);
+    TextureData tiled = row_major;
+    TextureCache::convertToTiled(tiled);
+
+    std::cout << "Texture " << size << "x" << size << ", " << channels << " channels, "
+              << samples << " samples x " << repeats << "\n";
+
+    bool consistent = true;
+    for (const auto&[name, uvs] : {std::make_pair("voxel walk", voxelWalkUVs(samples, size, texels_per_voxel)),
+                                   std::make_pair("random", randomUVs(samples))}) {
+        Result a = run(row_major, uvs, repeats);
+        Result b = run(tiled, uvs, repeats);
+        consistent = consistent && a.checksum == b.checksum;
+        std::cout << "  " << name << ": row-major " << a.ns_per_sample << " ns/sample, tiled "
+                  << b.ns_per_sample << " ns/sample (x" << a.ns_per_sample / b.ns_per_sample << ")\n";
+    }
+    if (!consistent) {
+        std::cerr << "Error: tiled and row-major layouts sampled different colours" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -2,12 +2,16 @@
 
 #include <nlohmann/json.hpp>
 #include <map>
+#include <unordered_map>
 #include <vector>
-#include <tuple>
+#include <array>
 #include <string>
+#include <cstdint>
+#include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <iostream>
+#include "types.h"
 
 using json = nlohmann::json;
 
@@ -38,20 +42,103 @@ struct Color {
     }
 };
 
+// Quad with 1-based vertex indices and a material index (atlas slot)
+struct ObjFace {
+    std::array<int, 4> indices;
+    int material;
+};
+
+// Axis-aligned box queued by a command, meshed later in parallel
+struct ObjBox {
+    Vec3 min;
+    Vec3 max;
+    int material;
+};
+
 class ObjGenerator {
 private:
     std::vector<Vec3> vertices;
-    std::vector<std::tuple<std::vector<int>, std::string>> faces;
-    std::map<Color, std::string> materials;
+    std::vector<ObjFace> faces;
+    std::map<Color, int> materials;
+    std::vector<Color> materialColors;
+    std::vector<Color> palette;
+    std::vector<int> paletteMaterials;
+    std::vector<ObjBox> pendingBoxes;
     int vertexOffset = 0;
+    unsigned threadCount = 0;
+    bool glbPerColor = false;
+
+    // glTF / OpenGL enums used by the GLB writer
+    static constexpr int kGlArrayBuffer = 34962;
+    static constexpr int kGlElementArrayBuffer = 34963;
+    static constexpr int kGlFloat = 5126;
+    static constexpr int kGlUnsignedInt = 5125;
+    static constexpr int kGlNearest = 9728;
+    static constexpr int kGlClampToEdge = 33071;
+
+    // Hidden-face culling: cells are collected first and meshed in writeToFile
+    bool cullHiddenFaces = false;
+    bool greedyMeshing = false;
+    std::unordered_map<long long, int> occupancy;
+    std::unordered_map<long long, int> latticeVertices;
 
-    void addCube(const Vec3& position, const std::string& materialName, double size = 1.0);
-    void addFilledArea(const Vec3& corner1, const Vec3& corner2, const std::string& materialName);
-    std::string getOrCreateMaterial(const Color& color);
+    // Streaming: vertices go straight to the OBJ, faces to a spill file appended at the end
+    static constexpr size_t kStreamFlushBoxes = 1 << 16;
+    bool streaming = false;
+    std::string streamFilename;
+    std::string spillFilename;
+    std::ofstream streamFile;
+    std::ofstream spillFile;
+
+    void addCube(const Vec3& position, int material, double size = 1.0);
+    void addFilledArea(const Vec3& corner1, const Vec3& corner2, int material);
+    static void appendBox(const ObjBox& box, int base, std::vector<Vec3>& outVertices,
+                          std::vector<ObjFace>& outFaces);
+    void generatePendingGeometry();
+    int getOrCreateMaterial(const Color& color);
+    int getOrCreateMaterial(int paletteIndex);
+    void markCells(int xMin, int yMin, int zMin, int xMax, int yMax, int zMax, int material);
+    void buildCulledGeometry();
+    void mergeSliceFaces(int axis, bool positive, int plane, std::vector<std::array<int, 3>>& slice);
+    int getLatticeVertex(int x, int y, int z);
+    void addQuad(int axis, bool positive, int plane, int u0, int v0, int u1, int v1, int material);
+    int atlasSize() const;
+    static std::string mtlFilenameFor(const std::string& filename);
+    void writeHeader(std::ofstream& file, const std::string& filename, bool withMaterials);
+    void writeVertices(std::ofstream& file);
+    void writeUVs(std::ofstream& file);
+    void writeFaces(std::ofstream& file);
+    void flushStream();
+    void finishStream();
     void writeMTLFile(const std::string& filename);
+    std::vector<uint8_t> buildAtlasPixels() const;
     void createColorTexture(const std::string& filename);
+    void writeGlb(const std::string& filename);
 
 public:
+    ~ObjGenerator();
+
+    // Threads used to mesh commands and format the OBJ text (0 = all cores)
+    void setThreadCount(unsigned threads) { threadCount = threads; }
+
+    // Emit only faces bordering empty cells, with vertices shared on the block lattice
+    void setCullHiddenFaces(bool enabled) { cullHiddenFaces = enabled; }
+    // Merge coplanar exposed faces of one material into maximal rectangles (implies culling)
+    void setGreedyMeshing(bool enabled) {
+        greedyMeshing = enabled;
+        if (enabled) cullHiddenFaces = true;
+    }
+
+    // GLB output: one flat-coloured primitive per colour instead of a texture atlas
+    void setGlbPerColor(bool enabled) { glbPerColor = enabled; }
+
+    // Colour table for schema v2 commands that carry a palette index
+    void setPalette(const json& paletteArray);
+    // Write geometry to filename as commands arrive so memory stays flat; not compatible
+    // with culling. writeToFile then finalizes this file and ignores its argument.
+    bool beginStream(const std::string& filename);
     void processCommand(const json& command);
+    void processCommand(const obj2blocks::MinecraftCommand& command);
+    // Writes OBJ + MTL + atlas, or a self-contained binary glTF when filename ends in .glb
     void writeToFile(const std::string& filename);
 };
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "types.h"
+
+namespace obj2blocks {
+    class BinaryExporter {
+    public:
+        BinaryExporter();
+
+        ~BinaryExporter();
+
+        bool exportToFile(const std::string&filename,
+                          const std::vector<MinecraftCommand>&commands,
+                          const ConversionParams&params);
+
+        std::vector<uint8_t> createBuffer(const std::vector<MinecraftCommand>&commands,
+                                          const ConversionParams&params);
+    };
+}
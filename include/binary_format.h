@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace obj2blocks {
+    // Compact binary command stream (".o2b")
+    //
+    //   magic "O2BC", u8 version
+    //   model info: varint source length + bytes, f64 target_size, voxel_size,
+    //               scale_factor, u8 flags, varint total_blocks, total_commands,
+    //               fillarea_commands, createblock_commands, [duplicate_blocks],
+    //               zigzag bbox min xyz, varint bbox extent xyz
+    //   palette:    varint count, count * RGBA bytes
+    //   commands:   varint tag (bit0 fillarea, bit1 colour change),
+    //               [varint palette index], zigzag min-corner delta xyz from
+    //               the previous command, [varint extent xyz for fillarea]
+    //
+    // All fixed-width values are little-endian.
+    namespace binary_format {
+        constexpr char kMagic[4] = {'O', '2', 'B', 'C'};
+        constexpr uint8_t kVersion = 1;
+
+        constexpr uint8_t kFlagAutoScale = 1 << 0;
+        constexpr uint8_t kFlagSolid = 1 << 1;
+        constexpr uint8_t kFlagOptimize = 1 << 2;
+        constexpr uint8_t kFlagHasDuplicates = 1 << 3;
+
+        constexpr uint64_t kTagFillArea = 1 << 0;
+        constexpr uint64_t kTagColorChange = 1 << 1;
+
+        inline uint64_t zigzagEncode(int64_t value) {
+            return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+        }
+
+        inline int64_t zigzagDecode(uint64_t value) {
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+
+        inline void writeVarint(std::vector<uint8_t>&out, uint64_t value) {
+            while (value >= 0x80) {
+                out.push_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<uint8_t>(value));
+        }
+
+        inline void writeDouble(std::vector<uint8_t>&out, double value) {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            for (int i = 0; i < 8; ++i) {
+                out.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+            }
+        }
+
+        // Decoding helpers return false once the input is exhausted
+        inline bool readVarint(const uint8_t*&p, const uint8_t* end, uint64_t&value) {
+            value = 0;
+            for (int shift = 0; shift < 64 && p < end; shift += 7) {
+                uint8_t byte = *p++;
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) return true;
+            }
+            return false;
+        }
+
+        inline bool readDouble(const uint8_t*&p, const uint8_t* end, double&value) {
+            if (end - p < 8) return false;
+            uint64_t bits = 0;
+            for (int i = 0; i < 8; ++i) {
+                bits |= static_cast<uint64_t>(p[i]) << (8 * i);
+            }
+            std::memcpy(&value, &bits, sizeof(value));
+            p += 8;
+            return true;
+        }
+    }
+}
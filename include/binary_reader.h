@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "types.h"
+
+namespace obj2blocks {
+    // Mirrors the JSON model_info block of a binary command stream
+    struct BinaryModelInfo {
+        std::string source;
+        double target_size = 0.0;
+        double voxel_size = 0.0;
+        double scale_factor = 0.0;
+        bool auto_scale = false;
+        bool solid_fill = false;
+        bool optimization_enabled = false;
+        long long total_blocks = 0;
+        long long total_commands = 0;
+        long long fillarea_commands = 0;
+        long long createblock_commands = 0;
+        long long duplicate_blocks = -1; // -1 when not recorded
+        Box3i bounding_box;
+    };
+
+    class BinaryReader {
+    public:
+        BinaryReader();
+
+        ~BinaryReader();
+
+        // True if the file starts with the binary command stream magic
+        static bool isBinaryFile(const std::string&filename);
+
+        bool readFile(const std::string&filename);
+
+        bool readBuffer(const uint8_t* data, size_t size);
+
+        const BinaryModelInfo& getModelInfo() const { return model_info_; }
+
+        const std::vector<Color4>& getPalette() const { return palette_; }
+
+        const std::vector<MinecraftCommand>& getCommands() const { return commands_; }
+
+    private:
+        BinaryModelInfo model_info_;
+        std::vector<Color4> palette_;
+        std::vector<MinecraftCommand> commands_;
+    };
+}
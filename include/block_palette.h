@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include "types.h"
+
+namespace obj2blocks {
+    // Maps block colours to the nearest solid Minecraft block (concrete and terracotta)
+    class BlockPalette {
+    public:
+        BlockPalette();
+
+        ~BlockPalette();
+
+        // Index into getBlockNames() of the closest block for a colour
+        int blockIndexFor(const Color4& color);
+
+        const std::string& blockFor(const Color4& color) { return getBlockNames()[blockIndexFor(color)]; }
+
+        static const std::vector<std::string>& getBlockNames();
+
+    private:
+        std::map<Color4, int> cache_;
+    };
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vector>
+#include "types.h"
+
+namespace obj2blocks {
+    // Summary figures shared by the exporters' model_info headers
+    struct CommandStats {
+        long long total_blocks = 0;
+        long long fillarea_commands = 0;
+        long long createblock_commands = 0;
+        long long duplicate_blocks = -1; // -1 when not computed
+        Box3i bounding_box;
+    };
+
+    CommandStats computeCommandStats(const std::vector<MinecraftCommand>&commands,
+                                     bool count_duplicates = true);
+
+    long long countDuplicateBlocks(const std::vector<MinecraftCommand>&commands);
+}
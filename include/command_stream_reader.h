@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <functional>
+#include <istream>
+#include <nlohmann/json.hpp>
+
+namespace obj2blocks {
+    // Streams the "commands" array of a command JSON file one element at a
+    // time, so memory use does not grow with the number of commands.
+    class CommandStreamReader {
+    public:
+        using CommandCallback = std::function<void(const nlohmann::json&command)>;
+        // Receives every other top-level member (model_info, ...) as it completes
+        using MemberCallback = std::function<void(const std::string&key, const nlohmann::json&value)>;
+
+        CommandStreamReader();
+
+        ~CommandStreamReader();
+
+        bool readFile(const std::string&filename, const CommandCallback&on_command,
+                      const MemberCallback&on_member = nullptr);
+
+        bool readStream(std::istream&stream, const CommandCallback&on_command,
+                        const MemberCallback&on_member = nullptr);
+
+        bool hasCommandsArray() const { return has_commands_array_; }
+
+        size_t getCommandCount() const { return command_count_; }
+
+    private:
+        bool has_commands_array_;
+        size_t command_count_;
+    };
+}
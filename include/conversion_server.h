@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <condition_variable>
+#include <istream>
+#include <ostream>
+#include <nlohmann/json.hpp>
+#include "types.h"
+#include "converter.h"
+#include "parallel.h"
+
+namespace obj2blocks {
+    // Long-running conversion service speaking line-delimited JSON. Each request line is
+    //   {"id": ..., "op": "convert", "input": "a.obj", "output": "a.json", "params": {...}}
+    // ("op" may also be "stats" or "shutdown"). Conversions run on a worker pool that
+    // shares warm texture and mesh caches, and each response line is written as soon
+    // as its job finishes, so responses can arrive out of order; match them by "id".
+    // With "output" the result is exported to that file; without it "return" picks what
+    // comes back inline: "commands" (default, the JSON document), "voxels", "both" or "none".
+    class ConversionServer {
+    public:
+        // `texture_params` selects the cache-wide mipmap and tiling options
+        ConversionServer(unsigned threads, const ConversionParams&texture_params);
+
+        ~ConversionServer();
+
+        // Parsed OBJ files kept warm (least recently used dropped first)
+        void setMeshCacheCapacity(size_t files);
+
+        // Decoded texture bytes kept warm (0 = unbounded)
+        void setTextureCacheBytes(size_t bytes);
+
+        // Serves requests read from `in` until end of input or a shutdown request
+        int serveStream(std::istream&in, std::ostream&out);
+
+        // Listens on a Unix domain socket until a shutdown request; every connection
+        // gets its own reader and shares the worker pool
+        int serveSocket(const std::string&path);
+
+    private:
+        // Where responses for one client go; lines are written whole under the mutex
+        struct Channel {
+            std::mutex mutex;
+            std::ostream* stream = nullptr;
+            int fd = -1;
+
+            ~Channel();
+
+            void send(const std::string&line);
+        };
+
+        // Handles one request line; returns false once the client asked to shut down
+        bool handleLine(const std::string&line, const std::shared_ptr<Channel>&channel);
+
+        nlohmann::json runJob(const nlohmann::json&request);
+
+        nlohmann::json statsJson() const;
+
+        void requestShutdown();
+
+        void readConnection(std::shared_ptr<Channel> channel);
+
+        // Request "params" on top of the defaults; false with `error` set on bad values
+        static bool paramsFromJson(const nlohmann::json&json, ConversionParams&params, std::string&error);
+
+        Converter converter_;
+        WorkerPool pool_;
+        std::atomic<bool> stopping_;
+        std::atomic<int> listen_fd_;
+        std::atomic<size_t> jobs_completed_;
+        std::atomic<size_t> jobs_failed_;
+        std::mutex connections_mutex_;
+        std::condition_variable readers_done_;
+        std::vector<std::shared_ptr<Channel>> connections_;
+        size_t active_readers_ = 0;
+    };
+}
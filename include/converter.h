@@ -0,0 +1,98 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include "types.h"
+#include "texture_cache.h"
+#include "profiler.h"
+#include "mesh_input.h"
+#include "mesh_cache.h"
+
+namespace obj2blocks {
+    // Outcome and per-stage wall times (seconds) of one OBJ conversion
+    struct ConversionResult {
+        bool success = false;
+        std::string error;
+        size_t total_voxels = 0;
+        size_t command_count = 0;
+        size_t textures_decoded = 0; // Images this conversion decoded rather than found cached
+        double scale_factor = 1.0; // Applied scale, computed when params.auto_scale is set
+        double load_seconds = 0.0;
+        double voxelize_seconds = 0.0;
+        double optimize_seconds = 0.0;
+        double export_seconds = 0.0;
+
+        // In-memory outputs of Converter::convertMesh, as selected by its MeshOutput
+        std::vector<MinecraftCommand> commands;
+        std::vector<VoxelData> voxels;
+
+        double totalSeconds() const { return load_seconds + voxelize_seconds + optimize_seconds + export_seconds; }
+    };
+
+    class MeshProcessor;
+    class ObjLoader;
+
+    // The obj2json pipeline: load, centre and scale, voxelize, optimize, export.
+    // convert() and convertMesh() keep no state between calls and may run
+    // concurrently on several threads; all of them share the converter's texture cache.
+    class Converter {
+    public:
+        Converter();
+
+        explicit Converter(std::shared_ptr<TextureCache> texture_cache);
+
+        ~Converter();
+
+        // A profiler, if given, receives every pipeline stage and the size counters
+        ConversionResult convert(const ConversionParams&params, Profiler* profiler = nullptr) const;
+
+        // Same pipeline on a mesh held in memory; nothing is read from or written to
+        // disk and params' file names are ignored. Results land in result.commands/voxels.
+        ConversionResult convertMesh(const MeshInput&mesh, const ConversionParams&params,
+                                     MeshOutput output = MeshOutput::Commands, Profiler* profiler = nullptr) const;
+
+        // Same pipeline on an OBJ file, returning results in memory instead of exporting
+        ConversionResult convertToMemory(const ConversionParams&params, MeshOutput output = MeshOutput::Commands,
+                                         Profiler* profiler = nullptr) const;
+
+        std::shared_ptr<TextureCache> getTextureCache() const { return texture_cache_; }
+
+        // Parsed OBJ files reused across conversions (null = parse every time). Set it
+        // before converting; it is not synchronised against concurrent convert() calls.
+        void setMeshCache(std::shared_ptr<MeshCache> mesh_cache) { mesh_cache_ = std::move(mesh_cache); }
+
+        std::shared_ptr<MeshCache> getMeshCache() const { return mesh_cache_; }
+
+        // Threads each conversion decodes textures on (0 = all cores). Callers running
+        // several conversions at once should split the cores between them.
+        void setDecodeThreads(unsigned threads) { decode_threads_ = threads; }
+
+        // Texture cache configured for params' mipmap and tiling options
+        static std::shared_ptr<TextureCache> createTextureCache(const ConversionParams&params);
+
+        // Explicit --format, else from the output extension, else json
+        static std::string resolveOutputFormat(const ConversionParams&params);
+
+        // json, o2b, mcfunction, schem or nbt
+        static bool isSupportedFormat(const std::string&format);
+
+        static bool exportCommands(const ConversionParams&params, const std::vector<MinecraftCommand>&commands);
+
+    private:
+        std::shared_ptr<TextureCache> texture_cache_;
+        std::shared_ptr<MeshCache> mesh_cache_;
+        unsigned decode_threads_ = 0;
+
+        // Loads params.input_file, through the mesh cache when one is set
+        bool loadFile(const ConversionParams&params, MeshProcessor&processor, ConversionResult&result,
+                      Profiler* profiler) const;
+
+        // Validates the mesh and fills a loader from it; null with result.error set on bad input
+        std::unique_ptr<ObjLoader> buildLoader(const MeshInput&mesh, ConversionResult&result) const;
+
+        // Centre/scale, voxelize and (unless output is Voxels) optimize a loaded mesh
+        bool process(MeshProcessor&processor, ConversionParams&params, MeshOutput output,
+                     ConversionResult&result, std::vector<MinecraftCommand>&commands, Profiler* profiler) const;
+    };
+}
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <vector>
+#include <ostream>
 #include <nlohmann/json.hpp>
 #include "types.h"
 
@@ -19,9 +20,10 @@ namespace obj2blocks {
         nlohmann::json createJson(const std::vector<MinecraftCommand>&commands,
                                   const ConversionParams&params);
 
+        // Writes the document with model_info and palette ahead of commands
+        void writeDocument(std::ostream&out, const nlohmann::json&json);
+
     private:
         nlohmann::json commandToJson(const MinecraftCommand&cmd);
-
-        int countTotalBlocks(const std::vector<MinecraftCommand>&commands);
     };
 }
@@ -2,29 +2,56 @@
 
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <filesystem>
+#include <memory>
 #include "types.h"
+#include "texture_cache.h"
+#include "material_sampler.h"
 
 namespace obj2blocks {
     class MaterialLoader {
     public:
         MaterialLoader();
+        // Shares decoded textures with other loaders using the same cache
+        explicit MaterialLoader(std::shared_ptr<TextureCache> texture_cache);
         ~MaterialLoader();
 
+        void setTextureCache(std::shared_ptr<TextureCache> texture_cache) { texture_cache_ = std::move(texture_cache); }
+        const std::shared_ptr<TextureCache>& getTextureCache() const { return texture_cache_; }
+        // Threads used to decode textures (0 = all cores)
+        void setThreadCount(unsigned threads) { threads_ = threads; }
+
+        // Parses material definitions only; textures are decoded by loadTextures
         bool loadMTL(const std::string& mtl_path);
+        // Decodes the diffuse, emissive and opacity maps of the named materials (in parallel);
+        // returns how many images were decoded rather than found in the cache
+        size_t loadTextures(const std::unordered_set<std::string>& material_names);
+        size_t loadAllTextures();
         bool loadTexture(const std::string& texture_path, TextureData& texture_data);
         Color4 sampleTexture(const TextureData& texture, float u, float v) const;
         
         const std::unordered_map<std::string, Material>& getMaterials() const { return materials_; }
         Material* getMaterial(const std::string& name);
+        const Material* getMaterial(const std::string& name) const;
+        // Registers an in-memory material; its textures map should already hold decoded images
+        void addMaterial(Material material);
         
         Color4 calculateFinalColor(const Material& material, float u, float v) const;
 
+        // Sampler for a material. Materials whose emissive or opacity map has to be combined
+        // with the diffuse one sample a baked final-colour image (MaterialSampler::bakeFinalColors)
+        // kept in the texture cache, keyed by the maps it was baked from
+        MaterialSampler createSampler(const Material& material) const;
+
     private:
         std::unordered_map<std::string, Material> materials_;
         std::filesystem::path base_path_;
+        std::unordered_map<std::string, std::filesystem::path> material_dirs_;
+        std::shared_ptr<TextureCache> texture_cache_;
+        unsigned threads_ = 0;
         
-        std::string resolvePath(const std::string& path) const;
+        std::string resolvePath(const std::string& material_name, const std::string& path) const;
         void parseMTLLine(const std::string& line, Material& current_material);
     };
 }
\ No newline at end of file
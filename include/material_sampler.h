@@ -0,0 +1,71 @@
+#pragma once
+
+#include "types.h"
+
+namespace obj2blocks {
+    // A material resolved for sampling: raw pointers to its decoded images, the flat
+    // colours and the branch flags, so no texture map lookups happen per sample.
+    // Pointers borrow from the Material's texture handles, which must outlive it.
+    class MaterialSampler {
+    public:
+        // Untextured white, as used for faces without a material
+        MaterialSampler();
+
+        explicit MaterialSampler(const Material&material);
+
+        // Uses a final-colour image from bakeFinalColors (if non-null) instead of combining
+        // the individual maps per sample; the sampler keeps the image alive
+        MaterialSampler(const Material&material, TextureHandle final_colors);
+
+        ~MaterialSampler();
+
+        // Mip level per texture channel; all zero samples the full-resolution images
+        struct Levels {
+            int diffuse = 0;
+            int emissive = 0;
+            int opacity = 0;
+        };
+
+        // Levels whose texels best match a voxel covering `uv_area_per_voxel` of UV space
+        Levels levelsFor(float uv_area_per_voxel) const;
+
+        // Same result as MaterialLoader::calculateFinalColor for the source material
+        Color4 sample(float u, float v) const { return sample(u, v, Levels()); }
+
+        Color4 sample(float u, float v, const Levels&levels) const;
+
+        // Texel (x, y) of a TextureLayout::Tiled image
+        static Color4 fetchTiled(const TextureData&texture, int x, int y);
+
+        // Texel (x, y) of an image in either layout, expanded to RGBA
+        static Color4 fetchTexel(const TextureData&texture, int x, int y);
+
+        // Largest image (texels at level 0) bakeFinalColors will build
+        static constexpr size_t kMaxBakeTexels = 2048 * 2048;
+
+        // True when an emissive or opacity map has to be combined with the diffuse colour per
+        // sample and all maps share dimensions within kMaxBakeTexels. A lone diffuse map is
+        // sampled directly, so it is never copied.
+        bool shouldBake() const;
+
+        // With nearest sampling the result only depends on the texel, so the combined colour
+        // can be precomputed per texel (and per mip level). Null unless shouldBake().
+        std::shared_ptr<TextureData> bakeFinalColors() const;
+
+        static int mipLevelFor(const TextureData*texture, float uv_area_per_voxel);
+
+        // Nearest-neighbour lookup with wrapped UVs and V flipped to image rows
+        static Color4 sampleTexture(const TextureData&texture, float u, float v);
+
+    private:
+        Color4 combine(Color4 color, const Color4* emissive, const Color4* opacity) const;
+
+        TextureHandle final_colors_;
+        const TextureData* diffuse_;
+        const TextureData* emissive_;
+        const TextureData* opacity_;
+        Color4 flat_color_;
+        int flat_emissive_[3];
+        bool has_flat_emissive_;
+    };
+}
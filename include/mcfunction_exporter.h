@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include "types.h"
+#include "block_palette.h"
+
+namespace obj2blocks {
+    // Writes setblock/fill commands as datapack .mcfunction files
+    class McfunctionExporter {
+    public:
+        McfunctionExporter();
+
+        ~McfunctionExporter();
+
+        // Outputs over the per-file limit are split into <name>_1.mcfunction, <name>_2.mcfunction, ...
+        bool exportToFile(const std::string&filename,
+                          const std::vector<MinecraftCommand>&commands);
+
+        void setMaxCommandsPerFile(size_t limit) { max_commands_per_file_ = limit; }
+
+        size_t getMaxCommandsPerFile() const { return max_commands_per_file_; }
+
+    private:
+        size_t max_commands_per_file_;
+        BlockPalette palette_;
+
+        size_t countLines(const std::vector<MinecraftCommand>&commands) const;
+
+        std::string partFilename(const std::string&filename, size_t part) const;
+    };
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <filesystem>
+#include "obj_loader.h"
+#include "texture_cache.h"
+
+namespace obj2blocks {
+    // Parsed OBJ files (geometry, materials and their decoded textures) kept for reuse by
+    // a long-running process. Entries are keyed by canonical path and whether textures were
+    // loaded, and reloaded when the file's size or modification time changes. The least
+    // recently used one is dropped once more than `capacity` files are cached, or while the
+    // textures that cached meshes hold keep the texture cache over its byte budget.
+    class MeshCache {
+    public:
+        explicit MeshCache(size_t capacity = 32);
+
+        ~MeshCache();
+
+        // Loaded OBJ for a path, parsing it (and with `with_textures` decoding its maps on
+        // `decode_threads` threads) on a miss; null if it cannot be loaded. The loader is
+        // shared with other requests as-is. `textures_decoded`, if given, receives how many
+        // images this call decoded.
+        std::shared_ptr<const ObjLoader> get(const std::string&path, const std::shared_ptr<TextureCache>&textures,
+                                             bool with_textures, unsigned decode_threads = 0,
+                                             size_t* textures_decoded = nullptr);
+
+        void setCapacity(size_t capacity);
+
+        size_t size() const;
+
+        size_t getHits() const;
+
+        size_t getMisses() const;
+
+        void clear();
+
+    private:
+        struct Entry {
+            std::string key;
+            std::filesystem::file_time_type modified;
+            uintmax_t file_size;
+            std::shared_ptr<const ObjLoader> loader;
+        };
+
+        // Drops least recently used entries beyond capacity_, and while `textures` is over budget
+        void evict(const std::shared_ptr<TextureCache>&textures);
+
+        size_t capacity_;
+        size_t hits_ = 0;
+        size_t misses_ = 0;
+        mutable std::mutex mutex_;
+        // Most recently used first
+        std::list<Entry> entries_;
+        std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    };
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "types.h"
+
+namespace obj2blocks {
+    // Texture referenced by a MeshInput material path: either an encoded image file
+    // (PNG, JPEG, ...) decoded through the converter's cache, or a decoded image
+    struct MeshTexture {
+        std::vector<uint8_t> encoded;
+        TextureHandle decoded; // Used as-is when set
+    };
+
+    // Triangle mesh held in memory, the input of Converter::convertMesh
+    struct MeshInput {
+        std::vector<float> positions; // x, y, z per vertex
+        std::vector<uint32_t> indices; // Three 0-based vertex indices per triangle
+        std::vector<float> uvs; // Optional u, v per vertex
+        std::vector<uint8_t> colors; // Optional r, g, b, a per vertex; used instead of materials
+        std::vector<int32_t> triangle_materials; // Optional index into materials per triangle, -1 = none
+        std::vector<Material> materials; // Texture paths are keys of textures
+        std::unordered_map<std::string, MeshTexture> textures;
+
+        size_t vertexCount() const { return positions.size() / 3; }
+
+        size_t triangleCount() const { return indices.size() / 3; }
+    };
+
+    // What Converter::convertMesh hands back besides its statistics
+    enum class MeshOutput {
+        Commands, // Optimized commands only
+        Voxels, // Voxels only; the optimizer is skipped
+        Both
+    };
+}
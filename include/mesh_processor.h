@@ -4,6 +4,7 @@
 #include <memory>
 #include <pmp/surface_mesh.h>
 #include "obj_loader.h"
+#include "profiler.h"
 
 namespace obj2blocks {
     class MeshProcessor {
@@ -12,7 +13,24 @@ namespace obj2blocks {
 
         ~MeshProcessor();
 
-        bool loadOBJ(const std::string&filename);
+        // Texture maps are decoded only with `load_textures`, for texture-mapped voxelization
+        bool loadOBJ(const std::string&filename, bool load_textures = false);
+
+        // Builds the mesh from a loader filled in memory (ObjLoader::addVertex/addFace) or one
+        // shared through a MeshCache; the loader is only read from here on
+        bool loadFromLoader(std::shared_ptr<const ObjLoader> obj_loader);
+
+        // Texture cache used by the next loadOBJ (null = a private cache)
+        void setTextureCache(std::shared_ptr<TextureCache> texture_cache) { texture_cache_ = std::move(texture_cache); }
+
+        // Receives parse, texture_load and mesh_build stages from loadOBJ; null = no profiling
+        void setProfiler(Profiler* profiler) { profiler_ = profiler; }
+
+        // Threads loadOBJ decodes textures on (0 = all cores)
+        void setDecodeThreads(unsigned threads) { decode_threads_ = threads; }
+
+        // Images the last loadOBJ decoded rather than found in the texture cache
+        size_t getTexturesDecoded() const { return textures_decoded_; }
 
         void scaleMesh(double scale_factor);
 
@@ -30,12 +48,14 @@ namespace obj2blocks {
         
         const ObjLoader& getObjLoader() const { return *obj_loader_; }
         
-        ObjLoader& getObjLoader() { return *obj_loader_; }
-        
         bool hasObjLoader() const { return obj_loader_ != nullptr; }
 
     private:
         pmp::SurfaceMesh mesh_;
-        std::unique_ptr<ObjLoader> obj_loader_;
+        std::shared_ptr<const ObjLoader> obj_loader_;
+        std::shared_ptr<TextureCache> texture_cache_;
+        Profiler* profiler_ = nullptr;
+        unsigned decode_threads_ = 0;
+        size_t textures_decoded_ = 0;
     };
 }
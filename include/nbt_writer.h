@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <zlib.h>
+
+namespace obj2blocks {
+    // Streaming writer for gzip-compressed big-endian NBT files
+    class NbtWriter {
+    public:
+        enum TagType : uint8_t {
+            TagEnd = 0,
+            TagByte = 1,
+            TagShort = 2,
+            TagInt = 3,
+            TagLong = 4,
+            TagFloat = 5,
+            TagDouble = 6,
+            TagByteArray = 7,
+            TagString = 8,
+            TagList = 9,
+            TagCompound = 10,
+            TagIntArray = 11
+        };
+
+        NbtWriter();
+
+        ~NbtWriter();
+
+        bool open(const std::string&filename);
+
+        bool close();
+
+        // Named tags
+        void beginCompound(const std::string&name);
+
+        void writeShort(const std::string&name, int16_t value);
+
+        void writeInt(const std::string&name, int32_t value);
+
+        void writeString(const std::string&name, const std::string&value);
+
+        void writeIntArray(const std::string&name, const std::vector<int32_t>&values);
+
+        // Followed by exactly `length` bytes passed to writeBytes()
+        void beginByteArray(const std::string&name, int32_t length);
+
+        // Followed by `count` payloads of `element_type`
+        void beginList(const std::string&name, TagType element_type, int32_t count);
+
+        // Closes a named compound or a compound list element
+        void endCompound();
+
+        // Unnamed payloads for list elements
+        void writeIntPayload(int32_t value);
+
+        void writeStringPayload(const std::string&value);
+
+        void writeBytes(const uint8_t* data, size_t size);
+
+    private:
+        gzFile file_;
+        std::vector<uint8_t> buffer_;
+        bool failed_;
+
+        void writeHeader(TagType type, const std::string&name);
+
+        void put(uint8_t byte) {
+            buffer_.push_back(byte);
+            if (buffer_.size() >= kBufferSize) flush();
+        }
+
+        void flush();
+
+        static constexpr size_t kBufferSize = 1 << 16;
+    };
+}
@@ -2,10 +2,12 @@
 
 #include <string>
 #include <vector>
+#include <array>
 #include <unordered_map>
 #include <pmp/surface_mesh.h>
 #include "types.h"
 #include "material_loader.h"
+#include "profiler.h"
 
 namespace obj2blocks {
     
@@ -19,21 +21,42 @@ struct FaceData {
 class ObjLoader {
 public:
     ObjLoader();
+    // Decodes textures through a cache shared with other loaders
+    explicit ObjLoader(std::shared_ptr<TextureCache> texture_cache);
     ~ObjLoader();
     
+    // Parses geometry and material definitions; textures are decoded by loadTextures
     bool load(const std::string& obj_path);
+
+    // Decodes the maps of materials used by faces, for texture-mapped voxelization;
+    // returns how many images were decoded rather than found in the cache
+    size_t loadTextures();
+
+    // Records the parse stage of load() and texture_load of loadTextures(); null = no profiling
+    void setProfiler(Profiler* profiler) { profiler_ = profiler; }
+
+    // In-memory construction instead of load(): 0-based indices, polygons are
+    // fan-triangulated; materials go through getMaterialLoader().addMaterial
+    void addVertex(const pmp::Point& position);
+    void addVertex(const pmp::Point& position, const Color4& color);
+    void addUV(const Vec2f& uv) { uvs_.push_back(uv); }
+    void addFace(const FaceData& face);
     
     const std::vector<pmp::Point>& getVertices() const { return vertices_; }
     const std::vector<Vec2f>& getUVs() const { return uvs_; }
     const std::vector<pmp::Point>& getNormals() const { return normals_; }
+    // `v x y z r g b` colours, one per vertex (white where a vertex had none); empty if none
+    const std::vector<Color4>& getVertexColors() const { return vertex_colors_; }
+    bool hasVertexColors() const { return !vertex_colors_.empty(); }
     const std::vector<FaceData>& getFaces() const { return faces_; }
     const MaterialLoader& getMaterialLoader() const { return material_loader_; }
     MaterialLoader& getMaterialLoader() { return material_loader_; }
     
-    bool buildSurfaceMesh(pmp::SurfaceMesh& mesh);
+    bool buildSurfaceMesh(pmp::SurfaceMesh& mesh) const;
     
     // Get material for a face
     Material* getMaterialForFace(size_t face_index);
+    const Material* getMaterialForFace(size_t face_index) const;
     
     // Get UV coordinates for a face vertex
     Vec2f getUVForFaceVertex(size_t face_index, size_t vertex_index) const;
@@ -42,12 +65,18 @@ private:
     std::vector<pmp::Point> vertices_;
     std::vector<Vec2f> uvs_;
     std::vector<pmp::Point> normals_;
+    std::vector<Color4> vertex_colors_;
+    // Colours as written in the file while parsing; NaN marks a vertex without one
+    std::vector<std::array<float, 3>> raw_vertex_colors_;
     std::vector<FaceData> faces_;
     MaterialLoader material_loader_;
     std::string current_material_;
+    Profiler* profiler_ = nullptr;
     
     void parseLine(const std::string& line);
     void parseVertex(const std::string& line);
+    // Converts raw_vertex_colors_ to vertex_colors_ with one scale for the whole file
+    void finishVertexColors();
     void parseUV(const std::string& line);
     void parseNormal(const std::string& line);
     void parseFace(const std::string& line);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace obj2blocks {
+    // Worker count for a requested thread count, where 0 means all hardware threads
+    unsigned resolveThreadCount(unsigned requested);
+
+    // Runs body(i) for every i in [0, count) on up to `threads` threads.
+    // Indices are handed out dynamically; the first exception is rethrown.
+    void parallelFor(size_t count, unsigned threads, const std::function<void(size_t)>&body);
+
+    // Fixed set of threads running submitted tasks in FIFO order, for long-lived
+    // producers that cannot hand parallelFor a count up front. Tasks must not throw.
+    class WorkerPool {
+    public:
+        // 0 = all hardware threads
+        explicit WorkerPool(unsigned threads = 0);
+
+        // Finishes every queued task, then joins the threads
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool&) = delete;
+
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        void submit(std::function<void()> task);
+
+        // Blocks until the queue is empty and no task is running
+        void wait();
+
+        unsigned getThreadCount() const { return static_cast<unsigned>(workers_.size()); }
+
+    private:
+        void run();
+
+        std::vector<std::thread> workers_;
+        std::deque<std::function<void()>> queue_;
+        std::mutex mutex_;
+        std::condition_variable task_ready_;
+        std::condition_variable idle_;
+        size_t running_ = 0;
+        bool stopping_ = false;
+    };
+}
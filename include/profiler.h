@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+namespace obj2blocks {
+    // Per-stage wall time, CPU time and peak RSS plus named counters for one
+    // conversion, written as a JSON report. Not thread-safe: one per conversion.
+    class Profiler {
+    public:
+        struct Stage {
+            std::string name;
+            double wall_seconds = 0.0;
+            double cpu_seconds = 0.0; // Whole process, so worker threads count too
+            uint64_t peak_rss_bytes = 0; // Process high-water mark when the stage ended
+        };
+
+        // Times the enclosing block as a stage; does nothing for a null profiler
+        class Scope {
+        public:
+            Scope(Profiler* profiler, const char* name);
+
+            ~Scope();
+
+            Scope(const Scope&) = delete;
+
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            Profiler* profiler_;
+            const char* name_;
+            std::chrono::steady_clock::time_point wall_start_;
+            double cpu_start_;
+        };
+
+        Profiler();
+
+        ~Profiler();
+
+        // Adds to the stage if it already ran, so a stage entered repeatedly is summed
+        void addStage(const std::string&name, double wall_seconds, double cpu_seconds);
+
+        void setCounter(const std::string&name, uint64_t value) { counters_[name] = value; }
+
+        void setInfo(const std::string&key, const std::string&value) { info_[key] = value; }
+
+        const std::vector<Stage>& getStages() const { return stages_; }
+
+        nlohmann::json toJson() const;
+
+        bool writeToFile(const std::string&filename) const;
+
+        static double processCpuSeconds();
+
+        static uint64_t peakRssBytes();
+
+    private:
+        std::chrono::steady_clock::time_point start_;
+        std::vector<Stage> stages_;
+        std::map<std::string, uint64_t> counters_;
+        std::map<std::string, std::string> info_;
+    };
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "types.h"
+
+namespace obj2blocks {
+    // Writes Sponge schematics (.schem, version 2) and vanilla structure files (.nbt)
+    class SchematicExporter {
+    public:
+        SchematicExporter();
+
+        ~SchematicExporter();
+
+        bool exportSchematic(const std::string&filename,
+                             const std::vector<MinecraftCommand>&commands);
+
+        bool exportStructure(const std::string&filename,
+                             const std::vector<MinecraftCommand>&commands);
+
+    private:
+        // Dense y/z/x grid of block indices (0 = air, n = block n - 1)
+        struct BlockGrid {
+            Vec3i origin;
+            int width = 0;  // x
+            int height = 0; // y
+            int length = 0; // z
+            std::vector<uint8_t> cells;
+
+            size_t index(int x, int y, int z) const {
+                return (static_cast<size_t>(y) * length + z) * width + x;
+            }
+        };
+
+        bool buildGrid(const std::vector<MinecraftCommand>&commands, BlockGrid&grid);
+    };
+}
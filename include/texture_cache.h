@@ -0,0 +1,128 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_set>
+#include <unordered_map>
+#include "types.h"
+
+namespace obj2blocks {
+    // Decoded textures shared by every material that references the same file.
+    // Images are immutable once decoded, so handles can be read from any thread.
+    // Each image is decoded by one thread; concurrent requests for it wait for that decode.
+    class TextureCache {
+    public:
+        TextureCache();
+
+        ~TextureCache();
+
+        // Cached image for a file, decoding it on first use; null if it cannot be loaded
+        TextureHandle get(const std::string&path);
+
+        // Decodes every path not yet cached on up to `threads` threads (0 = all cores).
+        // Returns how many images this call decoded and added to the cache.
+        size_t preload(const std::vector<std::string>&paths, unsigned threads = 0);
+
+        // Cached image for an encoded file held in memory, keyed by its contents so the
+        // same bytes from different requests decode once; null if it cannot be decoded.
+        // `decoded`, if given, is set when this call decoded the image.
+        TextureHandle getFromMemory(const std::vector<uint8_t>&bytes, bool* decoded = nullptr);
+
+        // Image computed from other cached images (such as a material's baked final colours),
+        // built on first use and cached under `key` while every source is still alive. It
+        // counts against the byte budget like decoded files; null if `build` returns null.
+        TextureHandle getDerived(const std::string&key, const std::vector<TextureHandle>&sources,
+                                 const std::function<std::shared_ptr<TextureData>()>&build);
+
+        size_t size() const;
+
+        // Bytes held by cached images, mip levels included
+        size_t memoryBytes() const;
+
+        // Evicts least recently used images once more than `bytes` are cached (0 = unbounded).
+        // Images still referenced outside the cache (by loaded materials, for example) are
+        // kept and counted, since dropping them would free nothing; the budget therefore
+        // covers every decoded image alive. An evicted image is decoded again on next use.
+        void setCapacityBytes(size_t bytes);
+
+        // More bytes held than the budget allows, even after evicting unreferenced images
+        bool overBudget() const;
+
+        // Evicts unreferenced images again, after holders such as cached meshes released theirs
+        void trim();
+
+        // Build a mip pyramid for textures decoded from now on
+        void setGenerateMipmaps(bool enabled) { generate_mipmaps_ = enabled; }
+
+        // Store textures decoded from now on in the tiled RGBA layout
+        void setTiledLayout(bool enabled) { tiled_layout_ = enabled; }
+
+        // Appends 2x2 box-filtered levels down to 1x1 (row-major textures only)
+        static void buildMipmaps(TextureData&texture);
+
+        // Re-lays a row-major texture and its mip levels as RGBA 8x8 tiles, so texels that
+        // are close in UV space share cache lines. Colours match the row-major lookup.
+        static void convertToTiled(TextureData&texture);
+
+        void clear();
+
+        // Decodes an image file with stb_image
+        static bool decode(const std::string&path, TextureData&texture);
+
+        static bool decodeMemory(const std::vector<uint8_t>&bytes, TextureData&texture);
+
+    private:
+        static std::string cacheKey(const std::string&path);
+
+        static std::string memoryKey(const std::vector<uint8_t>&bytes);
+
+        // Applies the mipmap and layout settings to a freshly decoded image
+        void prepare(TextureData&texture) const;
+
+        static size_t textureBytes(const TextureData&texture);
+
+        struct Entry {
+            TextureHandle texture;
+            uint64_t last_used = 0;
+            size_t bytes = 0;
+            // Images a derived entry was built from; it is stale once any of them is gone
+            std::vector<std::weak_ptr<const TextureData>> sources;
+        };
+
+        // Keys a thread has claimed for decoding; released (and waiters woken) on destruction,
+        // also when the decode throws
+        struct Claim {
+            TextureCache&cache;
+            std::vector<std::string> keys;
+
+            ~Claim();
+        };
+
+        // The helpers below expect mutex_ to be held
+        // Waits while another thread decodes `key`, then looks it up like touch()
+        const Entry* waitForDecode(std::unique_lock<std::mutex>&lock, const std::string&key);
+
+        // Cached entry for a key, marked as just used; null on a miss
+        const Entry* touch(const std::string&key);
+
+        // Inserts a decoded image (null = failed) unless another thread got there first
+        TextureHandle publish(const std::string&key, std::shared_ptr<TextureData> texture);
+
+        void evict(const std::string&keep);
+
+        bool generate_mipmaps_ = false;
+        bool tiled_layout_ = false;
+        mutable std::mutex mutex_;
+        // Failed loads are cached as null so they are not retried per material
+        std::unordered_map<std::string, Entry> textures_;
+        std::unordered_set<std::string> in_flight_;
+        std::condition_variable decoded_;
+        size_t capacity_bytes_ = 0;
+        size_t total_bytes_ = 0;
+        uint64_t clock_ = 0;
+    };
+}
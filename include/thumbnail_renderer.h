@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include "types.h"
+
+namespace obj2blocks {
+    enum class ThumbnailView {
+        Isometric,
+        Top
+    };
+
+    // Renders a command list straight to a PNG: boxes are projected orthographically,
+    // binned into screen tiles and rasterized with a z-buffer, one tile per worker.
+    class ThumbnailRenderer {
+    public:
+        ThumbnailRenderer();
+
+        ~ThumbnailRenderer();
+
+        void setSize(int width, int height);
+
+        void setView(ThumbnailView view) { view_ = view; }
+
+        // 0 = all cores
+        void setThreadCount(unsigned threads) { threads_ = threads; }
+
+        // Colour table for schema v2 commands that carry a palette index
+        void setPalette(const nlohmann::json&palette);
+
+        void addCommand(const nlohmann::json&command);
+
+        void addCommand(const MinecraftCommand&command);
+
+        size_t getBoxCount() const { return boxes_.size(); }
+
+        // RGBA pixels, width * height * 4, transparent background
+        std::vector<uint8_t> renderPixels() const;
+
+        bool renderToFile(const std::string&filename) const;
+
+    private:
+        // Half-open world-space box covering the command's cells
+        struct Box {
+            float min[3];
+            float max[3];
+            Color4 color;
+        };
+
+        int width_;
+        int height_;
+        ThumbnailView view_;
+        unsigned threads_;
+        std::vector<Box> boxes_;
+        std::vector<Color4> palette_;
+    };
+}
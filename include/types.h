@@ -5,6 +5,7 @@
 #include <vector>
 #include <memory>
 #include <unordered_map>
+#include <algorithm>
 
 namespace obj2blocks {
     struct Vec3i {
@@ -61,15 +62,35 @@ namespace obj2blocks {
         }
     };
 
+    enum class TextureLayout {
+        RowMajor, // `channels` bytes per texel, rows top to bottom
+        Tiled     // RGBA in 8x8 texel tiles (tile rows padded), see TextureCache::convertToTiled
+    };
+
     struct TextureData {
+        static constexpr int kTileSize = 8;
+
         std::vector<uint8_t> data;
         int width = 0;
         int height = 0;
         int channels = 0;
+        TextureLayout layout = TextureLayout::RowMajor;
+        
+        // Box-filtered downsampled copies: mip_levels[0] is level 1 (half size), and so on
+        std::vector<TextureData> mip_levels;
         
         bool isValid() const { return !data.empty() && width > 0 && height > 0; }
+
+        // Mip level `level`, clamped to the levels that exist (level 0 is this image)
+        const TextureData& level(int level) const {
+            if (level <= 0 || mip_levels.empty()) return *this;
+            return mip_levels[std::min<size_t>(level, mip_levels.size()) - 1];
+        }
     };
 
+    // Shared, immutable decoded image (see TextureCache)
+    using TextureHandle = std::shared_ptr<const TextureData>;
+
     struct Material {
         std::string name;
         
@@ -89,12 +110,12 @@ namespace obj2blocks {
         std::string normal_texture_path;    // map_Bump or norm
         std::string opacity_texture_path;   // map_d
         
-        // Loaded texture data
-        std::unordered_map<std::string, TextureData> textures;
+        // Loaded textures keyed by their MTL path; handles are shared between materials
+        std::unordered_map<std::string, TextureHandle> textures;
         
         bool hasDiffuseTexture() const { 
-            return textures.find(diffuse_texture_path) != textures.end() && 
-                   textures.at(diffuse_texture_path).isValid();
+            auto it = textures.find(diffuse_texture_path);
+            return it != textures.end() && it->second && it->second->isValid();
         }
     };
 
@@ -141,6 +162,7 @@ namespace obj2blocks {
     struct ConversionParams {
         std::string input_file;
         std::string output_file;
+        std::string output_format; // json, o2b, mcfunction, schem or nbt; empty = from extension
         double target_size = 200.0; // Target maximum dimension
         double voxel_size = 1.0; // Size of each voxel
         bool auto_scale = true; // Auto-calculate scale
@@ -148,5 +170,10 @@ namespace obj2blocks {
         bool solid = false; // Fill interior (true) or surface only (false)
         bool optimize = false; // Optimize with fillarea commands
         bool with_texture = false; // Use texture mapping for block colors
+        bool mipmaps = false; // Sample textures from a mip level matching the voxel footprint
+        bool tiled_textures = false; // Keep decoded textures in the tiled RGBA layout
+        double alpha_cutoff = 0.0; // Drop texture samples and voxels below this opacity (0-1, 0 = off)
+        bool count_duplicates = true; // Report duplicate_blocks in model_info
+        bool palette_colors = false; // JSON schema v2: palette table plus per-command colour index
     };
 }
@@ -4,6 +4,8 @@
 #include <pmp/surface_mesh.h>
 #include "types.h"
 #include "mesh_processor.h"
+#include "material_sampler.h"
+#include "profiler.h"
 
 namespace obj2blocks {
     class Voxelizer {
@@ -21,8 +23,20 @@ namespace obj2blocks {
 
         double getVoxelSize() const { return voxel_size_; }
 
+        // Opacity threshold (0-1) for material voxelization: samples below it are
+        // discarded and voxels whose average coverage falls below it are dropped
+        void setAlphaCutoff(double cutoff) { alpha_cutoff_ = cutoff; }
+
+        double getAlphaCutoff() const { return alpha_cutoff_; }
+
+        // Receives surface_voxelize, fill and dedupe stages; null = no profiling
+        void setProfiler(Profiler* profiler) { profiler_ = profiler; }
+
     private:
         double voxel_size_;
+        double alpha_cutoff_;
+        size_t alpha_culled_;
+        Profiler* profiler_;
 
         Vec3i pointToVoxel(const pmp::Point&point) const;
 
@@ -41,10 +55,19 @@ namespace obj2blocks {
         
         void rasterizeTriangleWithMaterial(const pmp::Point&v0, const pmp::Point&v1,
                                           const pmp::Point&v2, const Vec2f& uv0, const Vec2f& uv1,
-                                          const Vec2f& uv2, Material* material,
-                                          const MaterialLoader& mat_loader,
+                                          const Vec2f& uv2, const MaterialSampler& sampler,
                                           std::set<VoxelData>&voxels);
 
+        void rasterizeTriangleWithVertexColors(const pmp::Point&v0, const pmp::Point&v1,
+                                               const pmp::Point&v2, const Color4& c0, const Color4& c1,
+                                               const Color4& c2, std::set<VoxelData>&voxels);
+
+        // Shared triangle walk; color_at(w0, w1, w2) gives the colour at barycentric weights
+        template <typename ColorAt>
+        void rasterizeTriangleColored(const pmp::Point&v0, const pmp::Point&v1,
+                                      const pmp::Point&v2, const ColorAt& color_at,
+                                      std::set<VoxelData>&voxels);
+
         Box3i getBoundingBox(const std::set<Vec3i>&voxels) const;
         
         Box3i getBoundingBox(const std::set<VoxelData>&voxels) const;
@@ -2,35 +2,95 @@
 #include <algorithm>
 #include <vector>
 #include <cmath>
+#include <climits>
 #include <fstream>
+#include <charconv>
+#include <cstdio>
+#include <functional>
+#include "parallel.h"
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image_write.h>
 
-void ObjGenerator::addCube(const Vec3& position, const std::string& materialName, double size) {
-    double half = size / 2.0;
+namespace {
+    // Locale-independent shortest formatting straight into the output buffer
+    template <typename T>
+    void appendNumber(std::string& out, T value) {
+        char buffer[32];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+
+    // Formats [0, count) in fixed-size chunks on worker threads and writes them in order.
+    // Chunks are processed in batches so only a bounded amount of text is held at once.
+    void writeChunked(std::ofstream& file, size_t count, unsigned threads,
+                      const std::function<void(size_t, size_t, std::string&)>& format) {
+        constexpr size_t chunkSize = 1 << 16;
+        size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+        size_t batchSize = std::max<size_t>(1, obj2blocks::resolveThreadCount(threads)) * 2;
+
+        std::vector<std::string> buffers(std::min(batchSize, chunkCount));
+        for (size_t batchBegin = 0; batchBegin < chunkCount; batchBegin += batchSize) {
+            size_t batchEnd = std::min(chunkCount, batchBegin + batchSize);
+            obj2blocks::parallelFor(batchEnd - batchBegin, threads, [&](size_t i) {
+                size_t chunk = batchBegin + i;
+                std::string& out = buffers[i];
+                out.clear();
+                format(chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize), out);
+            });
+            for (size_t i = 0; i < batchEnd - batchBegin; ++i) {
+                file.write(buffers[i].data(), static_cast<std::streamsize>(buffers[i].size()));
+            }
+        }
+    }
 
-    vertices.push_back(Vec3(position.x - half, position.y - half, position.z - half));
-    vertices.push_back(Vec3(position.x + half, position.y - half, position.z - half));
-    vertices.push_back(Vec3(position.x + half, position.y + half, position.z - half));
-    vertices.push_back(Vec3(position.x - half, position.y + half, position.z - half));
-    vertices.push_back(Vec3(position.x - half, position.y - half, position.z + half));
-    vertices.push_back(Vec3(position.x + half, position.y - half, position.z + half));
-    vertices.push_back(Vec3(position.x + half, position.y + half, position.z + half));
-    vertices.push_back(Vec3(position.x - half, position.y + half, position.z + half));
+    bool isGlbFile(const std::string& filename) {
+        return filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".glb") == 0;
+    }
 
-    int base = vertexOffset + 1;
-    faces.push_back({{base, base + 1, base + 2, base + 3}, materialName});
-    faces.push_back({{base + 4, base + 7, base + 6, base + 5}, materialName});
-    faces.push_back({{base, base + 4, base + 5, base + 1}, materialName});
-    faces.push_back({{base + 1, base + 5, base + 6, base + 2}, materialName});
-    faces.push_back({{base + 2, base + 6, base + 7, base + 3}, materialName});
-    faces.push_back({{base + 3, base + 7, base + 4, base}, materialName});
+    void appendU32(std::string& out, uint32_t value) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            out += static_cast<char>((value >> shift) & 0xFF);
+        }
+    }
 
-    vertexOffset += 8;
+    // glTF colour factors are linear; block colours are sRGB
+    double srgbToLinear(int channel) {
+        double c = channel / 255.0;
+        return c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+    }
+
+    // Packs a lattice coordinate (21 bits per axis) into a hash key
+    long long latticeKey(int x, int y, int z) {
+        constexpr long long bias = 1 << 20;
+        constexpr long long mask = (1 << 21) - 1;
+        return (((x + bias) & mask) << 42) | (((y + bias) & mask) << 21) | ((z + bias) & mask);
+    }
 }
 
-void ObjGenerator::addFilledArea(const Vec3& corner1, const Vec3& corner2, const std::string& materialName) {
+ObjGenerator::~ObjGenerator() {
+    // Abandoned stream (e.g. the input failed to parse): drop the spill file
+    if (streaming) {
+        spillFile.close();
+        std::remove(spillFilename.c_str());
+    }
+}
+
+void ObjGenerator::addCube(const Vec3& position, int material, double size) {
+    if (cullHiddenFaces) {
+        int x = static_cast<int>(std::lround(position.x));
+        int y = static_cast<int>(std::lround(position.y));
+        int z = static_cast<int>(std::lround(position.z));
+        markCells(x, y, z, x, y, z, material);
+        return;
+    }
+
+    double half = size / 2.0;
+    pendingBoxes.push_back({Vec3(position.x - half, position.y - half, position.z - half),
+                            Vec3(position.x + half, position.y + half, position.z + half), material});
+}
+
+void ObjGenerator::addFilledArea(const Vec3& corner1, const Vec3& corner2, int material) {
     double xMin = std::min(corner1.x, corner2.x);
     double xMax = std::max(corner1.x, corner2.x);
     double yMin = std::min(corner1.y, corner2.y);
@@ -38,45 +98,261 @@ void ObjGenerator::addFilledArea(const Vec3& corner1, const Vec3& corner2, const
     double zMin = std::min(corner1.z, corner2.z);
     double zMax = std::max(corner1.z, corner2.z);
 
-    vertices.push_back(Vec3(xMin, yMin, zMin));
-    vertices.push_back(Vec3(xMax, yMin, zMin));
-    vertices.push_back(Vec3(xMax, yMax, zMin));
-    vertices.push_back(Vec3(xMin, yMax, zMin));
-    vertices.push_back(Vec3(xMin, yMin, zMax));
-    vertices.push_back(Vec3(xMax, yMin, zMax));
-    vertices.push_back(Vec3(xMax, yMax, zMax));
-    vertices.push_back(Vec3(xMin, yMax, zMax));
+    if (cullHiddenFaces) {
+        markCells(static_cast<int>(std::lround(xMin)), static_cast<int>(std::lround(yMin)),
+                  static_cast<int>(std::lround(zMin)), static_cast<int>(std::lround(xMax)),
+                  static_cast<int>(std::lround(yMax)), static_cast<int>(std::lround(zMax)), material);
+        return;
+    }
+
+    pendingBoxes.push_back({Vec3(xMin, yMin, zMin), Vec3(xMax, yMax, zMax), material});
+}
 
-    int base = vertexOffset + 1;
-    faces.push_back({{base, base + 1, base + 2, base + 3}, materialName});
-    faces.push_back({{base + 4, base + 7, base + 6, base + 5}, materialName});
-    faces.push_back({{base, base + 4, base + 5, base + 1}, materialName});
-    faces.push_back({{base + 1, base + 5, base + 6, base + 2}, materialName});
-    faces.push_back({{base + 2, base + 6, base + 7, base + 3}, materialName});
-    faces.push_back({{base + 3, base + 7, base + 4, base}, materialName});
+void ObjGenerator::appendBox(const ObjBox& box, int base, std::vector<Vec3>& outVertices,
+                             std::vector<ObjFace>& outFaces) {
+    const Vec3& lo = box.min;
+    const Vec3& hi = box.max;
+    outVertices.push_back(Vec3(lo.x, lo.y, lo.z));
+    outVertices.push_back(Vec3(hi.x, lo.y, lo.z));
+    outVertices.push_back(Vec3(hi.x, hi.y, lo.z));
+    outVertices.push_back(Vec3(lo.x, hi.y, lo.z));
+    outVertices.push_back(Vec3(lo.x, lo.y, hi.z));
+    outVertices.push_back(Vec3(hi.x, lo.y, hi.z));
+    outVertices.push_back(Vec3(hi.x, hi.y, hi.z));
+    outVertices.push_back(Vec3(lo.x, hi.y, hi.z));
 
-    vertexOffset += 8;
+    int material = box.material;
+    outFaces.push_back({{base, base + 1, base + 2, base + 3}, material});
+    outFaces.push_back({{base + 4, base + 7, base + 6, base + 5}, material});
+    outFaces.push_back({{base, base + 4, base + 5, base + 1}, material});
+    outFaces.push_back({{base + 1, base + 5, base + 6, base + 2}, material});
+    outFaces.push_back({{base + 2, base + 6, base + 7, base + 3}, material});
+    outFaces.push_back({{base + 3, base + 7, base + 4, base}, material});
+}
+
+void ObjGenerator::generatePendingGeometry() {
+    if (pendingBoxes.empty()) {
+        return;
+    }
+
+    // Each chunk is meshed on its own with indices relative to the chunk's first vertex
+    constexpr size_t chunkSize = 1 << 14;
+    size_t chunkCount = (pendingBoxes.size() + chunkSize - 1) / chunkSize;
+    std::vector<std::vector<Vec3>> chunkVertices(chunkCount);
+    std::vector<std::vector<ObjFace>> chunkFaces(chunkCount);
+
+    obj2blocks::parallelFor(chunkCount, threadCount, [&](size_t chunk) {
+        size_t begin = chunk * chunkSize;
+        size_t end = std::min(pendingBoxes.size(), begin + chunkSize);
+        auto& localVertices = chunkVertices[chunk];
+        auto& localFaces = chunkFaces[chunk];
+        localVertices.reserve((end - begin) * 8);
+        localFaces.reserve((end - begin) * 6);
+        for (size_t i = begin; i < end; ++i) {
+            appendBox(pendingBoxes[i], static_cast<int>(localVertices.size()), localVertices, localFaces);
+        }
+    });
+
+    // Prefix sums give every chunk its global vertex and face position
+    std::vector<size_t> vertexStart(chunkCount + 1, vertices.size());
+    std::vector<size_t> faceStart(chunkCount + 1, faces.size());
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+        vertexStart[chunk + 1] = vertexStart[chunk] + chunkVertices[chunk].size();
+        faceStart[chunk + 1] = faceStart[chunk] + chunkFaces[chunk].size();
+    }
+    vertices.resize(vertexStart[chunkCount]);
+    faces.resize(faceStart[chunkCount]);
+
+    obj2blocks::parallelFor(chunkCount, threadCount, [&](size_t chunk) {
+        std::copy(chunkVertices[chunk].begin(), chunkVertices[chunk].end(), vertices.begin() + vertexStart[chunk]);
+
+        // Patch chunk-relative indices to global 1-based OBJ indices
+        int shift = vertexOffset + static_cast<int>(vertexStart[chunk] - vertexStart[0]) + 1;
+        auto out = faces.begin() + faceStart[chunk];
+        for (ObjFace face : chunkFaces[chunk]) {
+            for (int& idx : face.indices) {
+                idx += shift;
+            }
+            *out++ = face;
+        }
+        std::vector<Vec3>().swap(chunkVertices[chunk]);
+        std::vector<ObjFace>().swap(chunkFaces[chunk]);
+    });
+
+    vertexOffset += static_cast<int>(vertexStart[chunkCount] - vertexStart[0]);
+    pendingBoxes.clear();
+}
+
+void ObjGenerator::markCells(int xMin, int yMin, int zMin, int xMax, int yMax, int zMax,
+                             int material) {
+    // Later commands overwrite earlier ones, as they would in game
+    for (int x = xMin; x <= xMax; ++x) {
+        for (int y = yMin; y <= yMax; ++y) {
+            for (int z = zMin; z <= zMax; ++z) {
+                occupancy[latticeKey(x, y, z)] = material;
+            }
+        }
+    }
+}
+
+int ObjGenerator::getLatticeVertex(int x, int y, int z) {
+    auto [it, inserted] = latticeVertices.emplace(latticeKey(x, y, z), vertexOffset + 1);
+    if (inserted) {
+        // Lattice point (x, y, z) is the min corner of the block centred on (x, y, z)
+        vertices.push_back(Vec3(x - 0.5, y - 0.5, z - 0.5));
+        vertexOffset++;
+    }
+    return it->second;
+}
+
+void ObjGenerator::addQuad(int axis, bool positive, int plane, int u0, int v0, int u1, int v1,
+                           int material) {
+    // u and v follow axis cyclically, so (u, v) winding faces +axis
+    int uAxis = (axis + 1) % 3;
+    int vAxis = (axis + 2) % 3;
+    int corners[4][2] = {{u0, v0}, {u1, v0}, {u1, v1}, {u0, v1}};
+    if (!positive) {
+        std::swap(corners[1], corners[3]);
+    }
+
+    ObjFace face{{}, material};
+    for (int i = 0; i < 4; ++i) {
+        int p[3];
+        p[axis] = plane;
+        p[uAxis] = corners[i][0];
+        p[vAxis] = corners[i][1];
+        face.indices[i] = getLatticeVertex(p[0], p[1], p[2]);
+    }
+    faces.push_back(face);
 }
 
-std::string ObjGenerator::getOrCreateMaterial(const Color& color) {
+void ObjGenerator::buildCulledGeometry() {
+    // Sort cells so the output does not depend on hash map iteration order
+    std::vector<std::pair<long long, int>> cells(occupancy.begin(), occupancy.end());
+    std::sort(cells.begin(), cells.end());
+
+    // Exposed faces grouped per axis-aligned slice for greedy merging
+    std::map<std::tuple<int, int, int>, std::vector<std::array<int, 3>>> slices;
+
+    constexpr long long bias = 1 << 20;
+    constexpr long long mask = (1 << 21) - 1;
+    for (const auto& [key, material] : cells) {
+        int cell[3] = {
+            static_cast<int>(((key >> 42) & mask) - bias),
+            static_cast<int>(((key >> 21) & mask) - bias),
+            static_cast<int>((key & mask) - bias)
+        };
+
+        for (int axis = 0; axis < 3; ++axis) {
+            int uAxis = (axis + 1) % 3;
+            int vAxis = (axis + 2) % 3;
+            for (int sign : {-1, 1}) {
+                int neighbour[3] = {cell[0], cell[1], cell[2]};
+                neighbour[axis] += sign;
+                if (occupancy.count(latticeKey(neighbour[0], neighbour[1], neighbour[2]))) {
+                    continue;
+                }
+                int plane = cell[axis] + (sign > 0 ? 1 : 0);
+                if (greedyMeshing) {
+                    slices[{axis, sign, plane}].push_back({cell[uAxis], cell[vAxis], material});
+                }
+                else {
+                    addQuad(axis, sign > 0, plane, cell[uAxis], cell[vAxis], cell[uAxis] + 1, cell[vAxis] + 1,
+                            material);
+                }
+            }
+        }
+    }
+
+    for (auto& [slice, sliceFaces] : slices) {
+        auto [axis, sign, plane] = slice;
+        mergeSliceFaces(axis, sign > 0, plane, sliceFaces);
+    }
+
+    occupancy.clear();
+    latticeVertices.clear();
+}
+
+void ObjGenerator::mergeSliceFaces(int axis, bool positive, int plane, std::vector<std::array<int, 3>>& slice) {
+    int uMin = INT_MAX, vMin = INT_MAX, uMax = INT_MIN, vMax = INT_MIN;
+    for (const auto& face : slice) {
+        uMin = std::min(uMin, face[0]);
+        uMax = std::max(uMax, face[0]);
+        vMin = std::min(vMin, face[1]);
+        vMax = std::max(vMax, face[1]);
+    }
+
+    // Dense mask of material index + 1 (0 = no face) over the slice bounds
+    int width = uMax - uMin + 1;
+    int height = vMax - vMin + 1;
+    std::vector<int> mask(static_cast<size_t>(width) * height, 0);
+    for (const auto& face : slice) {
+        mask[static_cast<size_t>(face[1] - vMin) * width + (face[0] - uMin)] = face[2] + 1;
+    }
+
+    for (int v = 0; v < height; ++v) {
+        for (int u = 0; u < width;) {
+            int material = mask[static_cast<size_t>(v) * width + u];
+            if (material == 0) {
+                ++u;
+                continue;
+            }
+
+            // Grow along u, then along v while the whole run matches
+            int runWidth = 1;
+            while (u + runWidth < width && mask[static_cast<size_t>(v) * width + u + runWidth] == material) {
+                ++runWidth;
+            }
+            int runHeight = 1;
+            for (; v + runHeight < height; ++runHeight) {
+                const int* row = &mask[static_cast<size_t>(v + runHeight) * width + u];
+                if (!std::all_of(row, row + runWidth, [material](int m) { return m == material; })) {
+                    break;
+                }
+            }
+
+            for (int dv = 0; dv < runHeight; ++dv) {
+                std::fill_n(&mask[static_cast<size_t>(v + dv) * width + u], runWidth, 0);
+            }
+
+            addQuad(axis, positive, plane, uMin + u, vMin + v, uMin + u + runWidth, vMin + v + runHeight,
+                    material - 1);
+            u += runWidth;
+        }
+    }
+}
+
+int ObjGenerator::getOrCreateMaterial(const Color& color) {
     auto it = materials.find(color);
     if (it != materials.end()) {
         return it->second;
     }
-    
-    std::string matName = color.toMaterialName();
-    materials[color] = matName;
-    return matName;
+
+    // Material indices double as atlas slots and UV indices
+    int material = static_cast<int>(materialColors.size());
+    materials[color] = material;
+    materialColors.push_back(color);
+    return material;
 }
 
-void ObjGenerator::processCommand(const json& command) {
-    std::string type = command["type"];
-    
-    // Extract color if present
-    Color color;
-    if (command.contains("color") && command["color"].is_array()) {
-        const auto& col = command["color"];
-        if (col.size() >= 3) {
+int ObjGenerator::getOrCreateMaterial(int paletteIndex) {
+    if (paletteIndex < 0 || paletteIndex >= static_cast<int>(palette.size())) {
+        std::cerr << "Warning: Palette index " << paletteIndex << " out of range, using default color" << std::endl;
+        return getOrCreateMaterial(Color());
+    }
+
+    int& material = paletteMaterials[paletteIndex];
+    if (material < 0) {
+        material = getOrCreateMaterial(palette[paletteIndex]);
+    }
+    return material;
+}
+
+void ObjGenerator::setPalette(const json& paletteArray) {
+    palette.clear();
+    for (const auto& col : paletteArray) {
+        Color color;
+        if (col.is_array() && col.size() >= 3) {
             color.r = col[0];
             color.g = col[1];
             color.b = col[2];
@@ -84,101 +360,244 @@ void ObjGenerator::processCommand(const json& command) {
                 color.a = col[3];
             }
         }
+        palette.push_back(color);
     }
+    paletteMaterials.assign(palette.size(), -1);
+}
+
+void ObjGenerator::processCommand(const json& command) {
+    std::string type = command["type"];
     
-    std::string materialName = getOrCreateMaterial(color);
+    int material;
+    if (command.contains("color") && command["color"].is_number_integer()) {
+        // Schema v2: index into the palette
+        material = getOrCreateMaterial(command["color"].get<int>());
+    }
+    else {
+        // Extract color if present
+        Color color;
+        if (command.contains("color") && command["color"].is_array()) {
+            const auto& col = command["color"];
+            if (col.size() >= 3) {
+                color.r = col[0];
+                color.g = col[1];
+                color.b = col[2];
+                if (col.size() >= 4) {
+                    color.a = col[3];
+                }
+            }
+        }
+        material = getOrCreateMaterial(color);
+    }
 
     if (type == "createblock") {
         const auto& pos = command["position"];
         Vec3 position(pos[0], pos[1], pos[2]);
-        addCube(position, materialName);
+        addCube(position, material);
     }
     else if (type == "fillarea") {
         const auto& c1 = command["corner1"];
         const auto& c2 = command["corner2"];
         Vec3 corner1(c1[0], c1[1], c1[2]);
         Vec3 corner2(c2[0], c2[1], c2[2]);
-        addFilledArea(corner1, corner2, materialName);
+        addFilledArea(corner1, corner2, material);
+    }
+
+    if (streaming && pendingBoxes.size() >= kStreamFlushBoxes) {
+        flushStream();
     }
 }
 
-void ObjGenerator::writeToFile(const std::string& filename) {
-    // Build reverse lookup: material name to color
-    std::map<std::string, Color> materialToColor;
-    std::map<Color, int> colorIndexMap;
-    int colorIdx = 0;
-    for (const auto& [color, matName] : materials) {
-        materialToColor[matName] = color;
-        colorIndexMap[color] = colorIdx++;
+void ObjGenerator::processCommand(const obj2blocks::MinecraftCommand& command) {
+    Color color(command.color.r, command.color.g, command.color.b, command.color.a);
+    int material = getOrCreateMaterial(color);
+
+    if (command.type == obj2blocks::CommandType::CreateBlock) {
+        const auto& pos = command.position;
+        addCube(Vec3(pos.x, pos.y, pos.z), material);
     }
-    
-    // Calculate texture atlas size
-    int atlasSize = std::ceil(std::sqrt(materials.size()));
-    if (atlasSize < 1) atlasSize = 1;
-    if (atlasSize > 256) atlasSize = 256;
-    
-    // Write MTL file if we have materials
-    if (!materials.empty()) {
-        std::string mtlFilename = filename.substr(0, filename.find_last_of('.')) + ".mtl";
-        writeMTLFile(mtlFilename);
+    else {
+        const auto& area = command.area;
+        addFilledArea(Vec3(area.min.x, area.min.y, area.min.z),
+                      Vec3(area.max.x, area.max.y, area.max.z), material);
     }
-    
-    std::ofstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error: Cannot open output file " << filename << std::endl;
-        return;
+
+    if (streaming && pendingBoxes.size() >= kStreamFlushBoxes) {
+        flushStream();
     }
+}
 
-    file << "# OBJ file generated from JSON commands\n";
-    file << "# Generated by Obj2Blocks converter\n\n";
+int ObjGenerator::atlasSize() const {
+    int size = std::ceil(std::sqrt(materials.size()));
+    if (size < 1) size = 1;
+    if (size > 256) size = 256;  // Max 256x256
+    return size;
+}
+
+std::string ObjGenerator::mtlFilenameFor(const std::string& filename) {
+    return filename.substr(0, filename.find_last_of('.')) + ".mtl";
+}
+
+void ObjGenerator::writeHeader(std::ofstream& file, const std::string& filename, bool withMaterials) {
+    std::string header = "# OBJ file generated from JSON commands\n"
+                         "# Generated by Obj2Blocks converter\n\n";
     
     // Reference MTL file if we have materials
-    if (!materials.empty()) {
+    if (withMaterials) {
         std::string mtlBasename = filename.substr(filename.find_last_of("/\\") + 1);
         mtlBasename = mtlBasename.substr(0, mtlBasename.find_last_of('.')) + ".mtl";
-        file << "mtllib " << mtlBasename << "\n";
-        file << "usemtl textured_blocks\n\n";
+        header += "mtllib " + mtlBasename + "\n";
+        header += "usemtl textured_blocks\n\n";
     }
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+}
 
-    // Write vertices
-    for (const auto& v : vertices) {
-        file << "v " << v.x << " " << v.y << " " << v.z << "\n";
+void ObjGenerator::writeVertices(std::ofstream& file) {
+    writeChunked(file, vertices.size(), threadCount, [this](size_t begin, size_t end, std::string& out) {
+        for (size_t i = begin; i < end; ++i) {
+            const Vec3& v = vertices[i];
+            out += "v ";
+            appendNumber(out, v.x);
+            out += ' ';
+            appendNumber(out, v.y);
+            out += ' ';
+            appendNumber(out, v.z);
+            out += '\n';
+        }
+    });
+}
+
+void ObjGenerator::writeUVs(std::ofstream& file) {
+    // One UV per material (its atlas texel), reused by every face of that material
+    int size = atlasSize();
+    std::string uvs = "\n# UV coordinates\n";
+    for (size_t idx = 0; idx < materialColors.size(); ++idx) {
+        int row = static_cast<int>(idx) / size;
+        int col = static_cast<int>(idx) % size;
+        float u = (col + 0.5f) / size;
+        float v = 1.0f - (row + 0.5f) / size;
+        uvs += "vt ";
+        appendNumber(uvs, u);
+        uvs += ' ';
+        appendNumber(uvs, v);
+        uvs += '\n';
     }
+    uvs += "\n# Faces with texture coordinates\n";
+    file.write(uvs.data(), static_cast<std::streamsize>(uvs.size()));
+}
 
-    file << "\n";
-    
-    // Pre-calculate UV coordinates for each material
-    std::map<std::string, std::pair<float, float>> materialUVs;
-    for (const auto& [matName, color] : materialToColor) {
-        int idx = colorIndexMap[color];
-        int row = idx / atlasSize;
-        int col = idx % atlasSize;
-        float u = (col + 0.5f) / atlasSize;
-        float v = 1.0f - (row + 0.5f) / atlasSize;
-        materialUVs[matName] = {u, v};
+void ObjGenerator::writeFaces(std::ofstream& file) {
+    // The UV index is the material index + 1
+    writeChunked(file, faces.size(), threadCount, [this](size_t begin, size_t end, std::string& out) {
+        for (size_t i = begin; i < end; ++i) {
+            const ObjFace& face = faces[i];
+            out += 'f';
+            for (int idx : face.indices) {
+                out += ' ';
+                appendNumber(out, idx);
+                out += '/';
+                appendNumber(out, face.material + 1);
+            }
+            out += '\n';
+        }
+    });
+}
+
+bool ObjGenerator::beginStream(const std::string& filename) {
+    if (cullHiddenFaces) {
+        std::cerr << "Error: Streaming output cannot be combined with face culling" << std::endl;
+        return false;
     }
-    
-    // Write UV coordinates - simplified: one UV per material, reused
-    file << "# UV coordinates\n";
-    std::map<std::string, int> materialUVIndex;
-    int uvIdx = 1;
-    for (const auto& [matName, uv] : materialUVs) {
-        file << "vt " << uv.first << " " << uv.second << "\n";
-        materialUVIndex[matName] = uvIdx++;
+    if (isGlbFile(filename)) {
+        std::cerr << "Error: Streaming output is only available for OBJ files" << std::endl;
+        return false;
+    }
+
+    streamFile.open(filename, std::ios::binary);
+    if (!streamFile.is_open()) {
+        std::cerr << "Error: Cannot open output file " << filename << std::endl;
+        return false;
     }
 
-    file << "\n# Faces with texture coordinates\n";
+    // Faces must follow the vt lines, which are only known at the end, so they are spilled
+    spillFilename = filename + ".faces.tmp";
+    spillFile.open(spillFilename, std::ios::binary | std::ios::trunc);
+    if (!spillFile.is_open()) {
+        std::cerr << "Error: Cannot open temporary file " << spillFilename << std::endl;
+        streamFile.close();
+        return false;
+    }
+
+    streamFilename = filename;
+    streaming = true;
+    writeHeader(streamFile, filename, true);
+    return true;
+}
+
+void ObjGenerator::flushStream() {
+    generatePendingGeometry();
+    writeVertices(streamFile);
+    writeFaces(spillFile);
+    vertices.clear();
+    faces.clear();
+}
+
+void ObjGenerator::finishStream() {
+    flushStream();
+    spillFile.close();
+    streaming = false;
+
+    writeUVs(streamFile);
+
+    std::ifstream spill(spillFilename, std::ios::binary);
+    if (spill.is_open()) {
+        streamFile << spill.rdbuf();
+        spill.close();
+    }
+    else {
+        std::cerr << "Error: Cannot reopen temporary file " << spillFilename << std::endl;
+    }
+    std::remove(spillFilename.c_str());
+
+    streamFile.close();
+    writeMTLFile(mtlFilenameFor(streamFilename));
+    std::cout << "OBJ file written to: " << streamFilename << std::endl;
+}
+
+void ObjGenerator::writeToFile(const std::string& filename) {
+    if (streaming) {
+        finishStream();
+        return;
+    }
+
+    if (cullHiddenFaces) {
+        buildCulledGeometry();
+    }
+    else {
+        generatePendingGeometry();
+    }
+
+    if (isGlbFile(filename)) {
+        writeGlb(filename);
+        return;
+    }
+
+    // Write MTL file if we have materials
+    if (!materials.empty()) {
+        writeMTLFile(mtlFilenameFor(filename));
+    }
     
-    // Write faces - much faster now
-    for (const auto& [faceIndices, matName] : faces) {
-        int uvIndex = materialUVIndex[matName];
-        file << "f";
-        for (int idx : faceIndices) {
-            file << " " << idx << "/" << uvIndex;
-        }
-        file << "\n";
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Cannot open output file " << filename << std::endl;
+        return;
     }
 
+    writeHeader(file, filename, !materials.empty());
+    writeVertices(file);
+    writeUVs(file);
+    writeFaces(file);
+
     file.close();
     std::cout << "OBJ file written to: " << filename << std::endl;
 }
@@ -212,17 +631,14 @@ void ObjGenerator::writeMTLFile(const std::string& filename) {
     std::cout << "MTL file written to: " << filename << std::endl;
 }
 
-void ObjGenerator::createColorTexture(const std::string& filename) {
-    // Create a simple texture atlas with one pixel per color
-    int atlasSize = std::ceil(std::sqrt(materials.size()));
-    if (atlasSize < 1) atlasSize = 1;
-    if (atlasSize > 256) atlasSize = 256;  // Max 256x256
-    
-    std::vector<uint8_t> pixels(atlasSize * atlasSize * 3, 255);
+std::vector<uint8_t> ObjGenerator::buildAtlasPixels() const {
+    // Simple texture atlas with one pixel per color
+    int size = atlasSize();
+    std::vector<uint8_t> pixels(size * size * 3, 255);
     
     int idx = 0;
-    for (const auto& [color, matName] : materials) {
-        if (idx >= atlasSize * atlasSize) break;
+    for (const auto& color : materialColors) {
+        if (idx >= size * size) break;
         
         int pixelIdx = idx * 3;
         pixels[pixelIdx] = color.r;
@@ -230,7 +646,228 @@ void ObjGenerator::createColorTexture(const std::string& filename) {
         pixels[pixelIdx + 2] = color.b;
         idx++;
     }
+    return pixels;
+}
+
+void ObjGenerator::createColorTexture(const std::string& filename) {
+    int size = atlasSize();
+    std::vector<uint8_t> pixels = buildAtlasPixels();
     
-    stbi_write_png(filename.c_str(), atlasSize, atlasSize, 3, pixels.data(), atlasSize * 3);
-    std::cout << "Color texture created: " << filename << " (" << atlasSize << "x" << atlasSize << ")" << std::endl;
-}
\ No newline at end of file
+    stbi_write_png(filename.c_str(), size, size, 3, pixels.data(), size * 3);
+    std::cout << "Color texture created: " << filename << " (" << size << "x" << size << ")" << std::endl;
+}
+
+void ObjGenerator::writeGlb(const std::string& filename) {
+    std::vector<uint8_t> bin;
+    json bufferViews = json::array();
+    json accessors = json::array();
+
+    // Appends a 4-byte aligned region of the binary chunk and returns its buffer view
+    auto addBufferView = [&](const void* data, size_t byteLength, int target) {
+        size_t byteOffset = bin.size();
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        bin.insert(bin.end(), bytes, bytes + byteLength);
+        bin.resize((bin.size() + 3) & ~static_cast<size_t>(3), 0);
+        json view = {{"buffer", 0}, {"byteOffset", byteOffset}, {"byteLength", byteLength}};
+        if (target != 0) {
+            view["target"] = target;
+        }
+        bufferViews.push_back(view);
+        return static_cast<int>(bufferViews.size() - 1);
+    };
+    auto addAccessor = [&](int view, size_t count, int componentType, const char* type) {
+        accessors.push_back({{"bufferView", view}, {"componentType", componentType},
+                             {"count", count}, {"type", type}});
+        return static_cast<int>(accessors.size() - 1);
+    };
+    auto addPositions = [&](const std::vector<float>& positions) {
+        std::array<float, 3> minPos = {0, 0, 0};
+        std::array<float, 3> maxPos = {0, 0, 0};
+        for (size_t i = 0; i < positions.size(); ++i) {
+            size_t axis = i % 3;
+            if (i < 3 || positions[i] < minPos[axis]) minPos[axis] = positions[i];
+            if (i < 3 || positions[i] > maxPos[axis]) maxPos[axis] = positions[i];
+        }
+        int view = addBufferView(positions.data(), positions.size() * sizeof(float), kGlArrayBuffer);
+        int accessor = addAccessor(view, positions.size() / 3, kGlFloat, "VEC3");
+        accessors[accessor]["min"] = minPos;
+        accessors[accessor]["max"] = maxPos;
+        return accessor;
+    };
+    auto addIndices = [&](const std::vector<uint32_t>& indices) {
+        int view = addBufferView(indices.data(), indices.size() * sizeof(uint32_t), kGlElementArrayBuffer);
+        return addAccessor(view, indices.size(), kGlUnsignedInt, "SCALAR");
+    };
+
+    json primitives = json::array();
+    json gltfMaterials = json::array();
+    json gltf = {
+        {"asset", {{"version", "2.0"}, {"generator", "Obj2Blocks converter"}}},
+        {"scene", 0},
+        {"scenes", json::array({{{"nodes", json::array({0})}}})},
+    };
+
+    if (glbPerColor) {
+        // Shared positions, one index list and flat-coloured material per colour
+        std::vector<float> positions;
+        positions.reserve(vertices.size() * 3);
+        for (const Vec3& v : vertices) {
+            positions.push_back(static_cast<float>(v.x));
+            positions.push_back(static_cast<float>(v.y));
+            positions.push_back(static_cast<float>(v.z));
+        }
+
+        std::vector<std::vector<uint32_t>> materialIndices(materialColors.size());
+        for (const ObjFace& face : faces) {
+            auto& indices = materialIndices[face.material];
+            const auto& q = face.indices;
+            for (int corner : {q[0], q[1], q[2], q[0], q[2], q[3]}) {
+                indices.push_back(static_cast<uint32_t>(corner - 1));
+            }
+        }
+
+        int positionAccessor = faces.empty() ? -1 : addPositions(positions);
+        for (size_t material = 0; material < materialColors.size(); ++material) {
+            if (materialIndices[material].empty()) continue;
+
+            const Color& color = materialColors[material];
+            json gltfMaterial = {
+                {"pbrMetallicRoughness", {
+                    {"baseColorFactor", {srgbToLinear(color.r), srgbToLinear(color.g),
+                                         srgbToLinear(color.b), color.a / 255.0}},
+                    {"metallicFactor", 0.0},
+                    {"roughnessFactor", 1.0}}},
+                {"doubleSided", true},
+            };
+            if (color.a < 255) {
+                gltfMaterial["alphaMode"] = "BLEND";
+            }
+            gltfMaterials.push_back(gltfMaterial);
+
+            primitives.push_back({{"attributes", {{"POSITION", positionAccessor}}},
+                                  {"indices", addIndices(materialIndices[material])},
+                                  {"material", gltfMaterials.size() - 1}});
+        }
+    }
+    else if (!faces.empty()) {
+        // Texture atlas: every vertex carries its material's texel, so vertices shared
+        // between materials (culled lattice) are split per material
+        int size = atlasSize();
+        std::vector<float> positions;
+        std::vector<float> texcoords;
+        std::vector<uint32_t> indices;
+        std::vector<int> firstMaterial(vertices.size(), -1);
+        std::vector<uint32_t> firstIndex(vertices.size());
+        std::unordered_map<long long, uint32_t> splitVertices;
+        positions.reserve(vertices.size() * 3);
+        texcoords.reserve(vertices.size() * 2);
+        indices.reserve(faces.size() * 6);
+
+        auto emitVertex = [&](int vertex, int material) {
+            const Vec3& v = vertices[vertex];
+            positions.push_back(static_cast<float>(v.x));
+            positions.push_back(static_cast<float>(v.y));
+            positions.push_back(static_cast<float>(v.z));
+            int row = material / size;
+            int col = material % size;
+            texcoords.push_back((col + 0.5f) / size);
+            texcoords.push_back((row + 0.5f) / size);  // glTF UVs start at the top row
+            return static_cast<uint32_t>(positions.size() / 3 - 1);
+        };
+        auto glbVertex = [&](int vertex, int material) {
+            if (firstMaterial[vertex] < 0) {
+                firstMaterial[vertex] = material;
+                firstIndex[vertex] = emitVertex(vertex, material);
+            }
+            if (firstMaterial[vertex] == material) {
+                return firstIndex[vertex];
+            }
+            long long key = static_cast<long long>(vertex) * static_cast<long long>(materialColors.size()) + material;
+            auto it = splitVertices.find(key);
+            if (it == splitVertices.end()) {
+                it = splitVertices.emplace(key, emitVertex(vertex, material)).first;
+            }
+            return it->second;
+        };
+
+        for (const ObjFace& face : faces) {
+            const auto& q = face.indices;
+            for (int corner : {q[0], q[1], q[2], q[0], q[2], q[3]}) {
+                indices.push_back(glbVertex(corner - 1, face.material));
+            }
+        }
+
+        int positionAccessor = addPositions(positions);
+        int texcoordView = addBufferView(texcoords.data(), texcoords.size() * sizeof(float), kGlArrayBuffer);
+        int texcoordAccessor = addAccessor(texcoordView, texcoords.size() / 2, kGlFloat, "VEC2");
+        int indexAccessor = addIndices(indices);
+
+        // Embed the atlas PNG in the binary chunk
+        std::vector<uint8_t> png;
+        std::vector<uint8_t> pixels = buildAtlasPixels();
+        stbi_write_png_to_func([](void* context, void* data, int length) {
+            auto* out = static_cast<std::vector<uint8_t>*>(context);
+            const auto* bytes = static_cast<const uint8_t*>(data);
+            out->insert(out->end(), bytes, bytes + length);
+        }, &png, size, size, 3, pixels.data(), size * 3);
+        int imageView = addBufferView(png.data(), png.size(), 0);
+
+        gltf["images"] = json::array({{{"bufferView", imageView}, {"mimeType", "image/png"}}});
+        gltf["samplers"] = json::array({{{"magFilter", kGlNearest}, {"minFilter", kGlNearest},
+                                         {"wrapS", kGlClampToEdge}, {"wrapT", kGlClampToEdge}}});
+        gltf["textures"] = json::array({{{"sampler", 0}, {"source", 0}}});
+        gltfMaterials.push_back({
+            {"name", "textured_blocks"},
+            {"pbrMetallicRoughness", {
+                {"baseColorTexture", {{"index", 0}}},
+                {"metallicFactor", 0.0},
+                {"roughnessFactor", 1.0}}},
+            {"doubleSided", true},
+        });
+        primitives.push_back({{"attributes", {{"POSITION", positionAccessor}, {"TEXCOORD_0", texcoordAccessor}}},
+                              {"indices", indexAccessor},
+                              {"material", 0}});
+    }
+
+    if (primitives.empty()) {
+        gltf["nodes"] = json::array({json::object()});
+    }
+    else {
+        gltf["nodes"] = json::array({{{"mesh", 0}}});
+        gltf["meshes"] = json::array({{{"primitives", primitives}}});
+        gltf["materials"] = gltfMaterials;
+        gltf["accessors"] = accessors;
+        gltf["bufferViews"] = bufferViews;
+        gltf["buffers"] = json::array({{{"byteLength", bin.size()}}});
+    }
+
+    std::string jsonChunk = gltf.dump();
+    jsonChunk.resize((jsonChunk.size() + 3) & ~static_cast<size_t>(3), ' ');
+
+    std::string header;
+    size_t totalLength = 12 + 8 + jsonChunk.size() + (bin.empty() ? 0 : 8 + bin.size());
+    appendU32(header, 0x46546C67);  // "glTF"
+    appendU32(header, 2);
+    appendU32(header, static_cast<uint32_t>(totalLength));
+    appendU32(header, static_cast<uint32_t>(jsonChunk.size()));
+    appendU32(header, 0x4E4F534A);  // "JSON"
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Cannot open output file " << filename << std::endl;
+        return;
+    }
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+    file.write(jsonChunk.data(), static_cast<std::streamsize>(jsonChunk.size()));
+    if (!bin.empty()) {
+        std::string binHeader;
+        appendU32(binHeader, static_cast<uint32_t>(bin.size()));
+        appendU32(binHeader, 0x004E4942);  // "BIN\0"
+        file.write(binHeader.data(), static_cast<std::streamsize>(binHeader.size()));
+        file.write(reinterpret_cast<const char*>(bin.data()), static_cast<std::streamsize>(bin.size()));
+    }
+
+    file.close();
+    std::cout << "GLB file written to: " << filename << " (" << faces.size() * 2 << " triangles, "
+              << materialColors.size() << " colors)" << std::endl;
+}
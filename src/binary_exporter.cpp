@@ -0,0 +1,129 @@
+#include "binary_exporter.h"
+#include "binary_format.h"
+#include "command_stats.h"
+#include <fstream>
+#include <iostream>
+#include <map>
+
+namespace obj2blocks {
+    BinaryExporter::BinaryExporter() {
+    }
+
+    BinaryExporter::~BinaryExporter() {
+    }
+
+    bool BinaryExporter::exportToFile(const std::string&filename,
+                                      const std::vector<MinecraftCommand>&commands,
+                                      const ConversionParams&params) {
+        try {
+            std::vector<uint8_t> buffer = createBuffer(commands, params);
+
+            std::ofstream file(filename, std::ios::binary);
+            if (!file.is_open()) {
+                std::cerr << "Error: Could not open file for writing: " << filename << std::endl;
+                return false;
+            }
+
+            file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+            file.close();
+
+            std::cout << "Successfully exported to: " << filename << " (" << buffer.size() << " bytes)\n";
+            return true;
+        }
+        catch (const std::exception&e) {
+            std::cerr << "Error exporting binary commands: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    std::vector<uint8_t> BinaryExporter::createBuffer(const std::vector<MinecraftCommand>&commands,
+                                                      const ConversionParams&params) {
+        using namespace binary_format;
+
+        CommandStats stats = computeCommandStats(commands, params.count_duplicates);
+        const Box3i&bbox = commands.empty() ? Box3i() : stats.bounding_box;
+
+        std::vector<uint8_t> out;
+        out.reserve(64 + params.input_file.size() + commands.size() * 5);
+
+        for (char c: kMagic) out.push_back(static_cast<uint8_t>(c));
+        out.push_back(kVersion);
+
+        // Model info
+        writeVarint(out, params.input_file.size());
+        out.insert(out.end(), params.input_file.begin(), params.input_file.end());
+        writeDouble(out, params.target_size);
+        writeDouble(out, params.voxel_size);
+        writeDouble(out, params.scale_factor);
+
+        uint8_t flags = 0;
+        if (params.auto_scale) flags |= kFlagAutoScale;
+        if (params.solid) flags |= kFlagSolid;
+        if (params.optimize) flags |= kFlagOptimize;
+        if (params.count_duplicates) flags |= kFlagHasDuplicates;
+        out.push_back(flags);
+
+        writeVarint(out, stats.total_blocks);
+        writeVarint(out, commands.size());
+        writeVarint(out, stats.fillarea_commands);
+        writeVarint(out, stats.createblock_commands);
+        if (params.count_duplicates) {
+            writeVarint(out, stats.duplicate_blocks);
+        }
+
+        writeVarint(out, zigzagEncode(bbox.min.x));
+        writeVarint(out, zigzagEncode(bbox.min.y));
+        writeVarint(out, zigzagEncode(bbox.min.z));
+        writeVarint(out, static_cast<uint64_t>(bbox.max.x - bbox.min.x));
+        writeVarint(out, static_cast<uint64_t>(bbox.max.y - bbox.min.y));
+        writeVarint(out, static_cast<uint64_t>(bbox.max.z - bbox.min.z));
+
+        // Palette in order of first use
+        std::map<Color4, uint32_t> palette_index;
+        std::vector<Color4> palette;
+        for (const auto&cmd: commands) {
+            if (palette_index.emplace(cmd.color, static_cast<uint32_t>(palette.size())).second) {
+                palette.push_back(cmd.color);
+            }
+        }
+
+        writeVarint(out, palette.size());
+        for (const auto&color: palette) {
+            out.push_back(color.r);
+            out.push_back(color.g);
+            out.push_back(color.b);
+            out.push_back(color.a);
+        }
+
+        // Commands, delta-encoded in optimizer order
+        Vec3i previous = bbox.min;
+        uint32_t current_color = UINT32_MAX;
+        for (const auto&cmd: commands) {
+            bool is_fill = cmd.type == CommandType::FillArea;
+            const Vec3i&corner = is_fill ? cmd.area.min : cmd.position;
+            uint32_t color = palette_index[cmd.color];
+
+            uint64_t tag = is_fill ? kTagFillArea : 0;
+            if (color != current_color) tag |= kTagColorChange;
+            writeVarint(out, tag);
+            if (color != current_color) {
+                writeVarint(out, color);
+                current_color = color;
+            }
+
+            writeVarint(out, zigzagEncode(static_cast<int64_t>(corner.x) - previous.x));
+            writeVarint(out, zigzagEncode(static_cast<int64_t>(corner.y) - previous.y));
+            writeVarint(out, zigzagEncode(static_cast<int64_t>(corner.z) - previous.z));
+
+            if (is_fill) {
+                writeVarint(out, static_cast<uint64_t>(cmd.area.max.x - cmd.area.min.x));
+                writeVarint(out, static_cast<uint64_t>(cmd.area.max.y - cmd.area.min.y));
+                writeVarint(out, static_cast<uint64_t>(cmd.area.max.z - cmd.area.min.z));
+            }
+
+            previous = corner;
+        }
+
+        return out;
+    }
+}
@@ -0,0 +1,162 @@
+#include "binary_reader.h"
+#include "binary_format.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace obj2blocks {
+    BinaryReader::BinaryReader() {
+    }
+
+    BinaryReader::~BinaryReader() {
+    }
+
+    bool BinaryReader::isBinaryFile(const std::string&filename) {
+        std::ifstream file(filename, std::ios::binary);
+        char magic[sizeof(binary_format::kMagic)] = {};
+        if (!file.read(magic, sizeof(magic))) return false;
+        return std::equal(std::begin(magic), std::end(magic), std::begin(binary_format::kMagic));
+    }
+
+    bool BinaryReader::readFile(const std::string&filename) {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            std::cerr << "Error: Cannot open input file " << filename << std::endl;
+            return false;
+        }
+
+        std::streamsize size = file.tellg();
+        file.seekg(0);
+        std::vector<uint8_t> buffer(static_cast<size_t>(size));
+        if (!file.read(reinterpret_cast<char*>(buffer.data()), size)) {
+            std::cerr << "Error: Failed to read " << filename << std::endl;
+            return false;
+        }
+
+        return readBuffer(buffer.data(), buffer.size());
+    }
+
+    bool BinaryReader::readBuffer(const uint8_t* data, size_t size) {
+        using namespace binary_format;
+
+        model_info_ = BinaryModelInfo();
+        palette_.clear();
+        commands_.clear();
+
+        const uint8_t* p = data;
+        const uint8_t* end = data + size;
+
+        if (size < sizeof(kMagic) + 1 || !std::equal(std::begin(kMagic), std::end(kMagic), p)) {
+            std::cerr << "Error: Not a binary command stream" << std::endl;
+            return false;
+        }
+        p += sizeof(kMagic);
+
+        uint8_t version = *p++;
+        if (version != kVersion) {
+            std::cerr << "Error: Unsupported binary command stream version " << int(version) << std::endl;
+            return false;
+        }
+
+        auto truncated = []() {
+            std::cerr << "Error: Binary command stream is truncated" << std::endl;
+            return false;
+        };
+
+        // Model info
+        uint64_t source_length;
+        if (!readVarint(p, end, source_length) || static_cast<uint64_t>(end - p) < source_length) return truncated();
+        model_info_.source.assign(reinterpret_cast<const char*>(p), source_length);
+        p += source_length;
+
+        if (!readDouble(p, end, model_info_.target_size) ||
+            !readDouble(p, end, model_info_.voxel_size) ||
+            !readDouble(p, end, model_info_.scale_factor) ||
+            p >= end) {
+            return truncated();
+        }
+
+        uint8_t flags = *p++;
+        model_info_.auto_scale = flags & kFlagAutoScale;
+        model_info_.solid_fill = flags & kFlagSolid;
+        model_info_.optimization_enabled = flags & kFlagOptimize;
+
+        uint64_t total_blocks, total_commands, fillarea_commands, createblock_commands;
+        if (!readVarint(p, end, total_blocks) || !readVarint(p, end, total_commands) ||
+            !readVarint(p, end, fillarea_commands) || !readVarint(p, end, createblock_commands)) {
+            return truncated();
+        }
+        model_info_.total_blocks = static_cast<long long>(total_blocks);
+        model_info_.total_commands = static_cast<long long>(total_commands);
+        model_info_.fillarea_commands = static_cast<long long>(fillarea_commands);
+        model_info_.createblock_commands = static_cast<long long>(createblock_commands);
+
+        if (flags & kFlagHasDuplicates) {
+            uint64_t duplicate_blocks;
+            if (!readVarint(p, end, duplicate_blocks)) return truncated();
+            model_info_.duplicate_blocks = static_cast<long long>(duplicate_blocks);
+        }
+
+        uint64_t bbox[6];
+        for (uint64_t&value: bbox) {
+            if (!readVarint(p, end, value)) return truncated();
+        }
+        Vec3i bbox_min(static_cast<int>(zigzagDecode(bbox[0])),
+                       static_cast<int>(zigzagDecode(bbox[1])),
+                       static_cast<int>(zigzagDecode(bbox[2])));
+        model_info_.bounding_box = Box3i(bbox_min, Vec3i(bbox_min.x + static_cast<int>(bbox[3]),
+                                                         bbox_min.y + static_cast<int>(bbox[4]),
+                                                         bbox_min.z + static_cast<int>(bbox[5])));
+
+        // Palette
+        uint64_t palette_size;
+        if (!readVarint(p, end, palette_size) || static_cast<uint64_t>(end - p) / 4 < palette_size) return truncated();
+        palette_.reserve(palette_size);
+        for (uint64_t i = 0; i < palette_size; ++i, p += 4) {
+            palette_.emplace_back(p[0], p[1], p[2], p[3]);
+        }
+
+        // Commands: at least a tag and three corner varints each, so a corrupt count is
+        // rejected here instead of reserving memory for it
+        if (static_cast<uint64_t>(end - p) / 4 < total_commands) return truncated();
+        commands_.reserve(total_commands);
+        Vec3i previous = bbox_min;
+        Color4 color;
+        for (uint64_t i = 0; i < total_commands; ++i) {
+            uint64_t tag;
+            if (!readVarint(p, end, tag)) return truncated();
+
+            if (tag & kTagColorChange) {
+                uint64_t index;
+                if (!readVarint(p, end, index)) return truncated();
+                if (index >= palette_.size()) {
+                    std::cerr << "Error: Palette index out of range in binary command stream" << std::endl;
+                    return false;
+                }
+                color = palette_[index];
+            }
+
+            uint64_t dx, dy, dz;
+            if (!readVarint(p, end, dx) || !readVarint(p, end, dy) || !readVarint(p, end, dz)) return truncated();
+            Vec3i corner(previous.x + static_cast<int>(zigzagDecode(dx)),
+                         previous.y + static_cast<int>(zigzagDecode(dy)),
+                         previous.z + static_cast<int>(zigzagDecode(dz)));
+
+            if (tag & kTagFillArea) {
+                uint64_t ex, ey, ez;
+                if (!readVarint(p, end, ex) || !readVarint(p, end, ey) || !readVarint(p, end, ez)) return truncated();
+                Vec3i corner2(corner.x + static_cast<int>(ex),
+                              corner.y + static_cast<int>(ey),
+                              corner.z + static_cast<int>(ez));
+                commands_.emplace_back(Box3i(corner, corner2), color);
+            }
+            else {
+                commands_.emplace_back(corner, color);
+            }
+
+            previous = corner;
+        }
+
+        return true;
+    }
+}
@@ -18,7 +18,7 @@ namespace obj2blocks {
             return commands;
         }
 
-        std::cout << "Optimizing " << voxels.size() << " blocks..." << std::endl;
+        std::cout << "Optimizing " << voxels.size() << " blocks...\n";
 
         std::set<Vec3i> remaining_voxels = voxels;
         std::vector<Box3i> regions = findRectangularRegions(remaining_voxels);
@@ -31,9 +31,9 @@ namespace obj2blocks {
             commands.emplace_back(voxel, Color4());  // Default color
         }
 
-        std::cout << "Optimized to " << commands.size() << " commands" << std::endl;
-        std::cout << "  - FillArea commands: " << regions.size() << std::endl;
-        std::cout << "  - CreateBlock commands: " << remaining_voxels.size() << std::endl;
+        std::cout << "Optimized to " << commands.size() << " commands\n";
+        std::cout << "  - FillArea commands: " << regions.size() << '\n';
+        std::cout << "  - CreateBlock commands: " << remaining_voxels.size() << '\n';
 
         return commands;
     }
@@ -118,7 +118,7 @@ namespace obj2blocks {
             return commands;
         }
         
-        std::cout << "Optimizing " << voxels.size() << " colored blocks..." << std::endl;
+        std::cout << "Optimizing " << voxels.size() << " colored blocks...\n";
         
         // Group voxels by color
         std::map<Color4, std::set<Vec3i>> voxels_by_color;
@@ -126,7 +126,7 @@ namespace obj2blocks {
             voxels_by_color[vd.color].insert(vd.position);
         }
         
-        std::cout << "Found " << voxels_by_color.size() << " unique colors" << std::endl;
+        std::cout << "Found " << voxels_by_color.size() << " unique colors\n";
         
         int total_fillarea = 0;
         int total_createblock = 0;
@@ -147,9 +147,9 @@ namespace obj2blocks {
             }
         }
         
-        std::cout << "Optimized to " << commands.size() << " commands" << std::endl;
-        std::cout << "  - FillArea commands: " << total_fillarea << std::endl;
-        std::cout << "  - CreateBlock commands: " << total_createblock << std::endl;
+        std::cout << "Optimized to " << commands.size() << " commands\n";
+        std::cout << "  - FillArea commands: " << total_fillarea << '\n';
+        std::cout << "  - CreateBlock commands: " << total_createblock << '\n';
         
         return commands;
     }
@@ -0,0 +1,88 @@
+#include "block_palette.h"
+#include <climits>
+
+namespace obj2blocks {
+    namespace {
+        struct BlockColor {
+            const char* name;
+            int r, g, b;
+        };
+
+        // Average texture colours of the full-block concrete and terracotta sets
+        const BlockColor kBlockColors[] = {
+            {"minecraft:white_concrete", 207, 213, 214},
+            {"minecraft:orange_concrete", 224, 97, 1},
+            {"minecraft:magenta_concrete", 169, 48, 159},
+            {"minecraft:light_blue_concrete", 36, 137, 199},
+            {"minecraft:yellow_concrete", 241, 175, 21},
+            {"minecraft:lime_concrete", 94, 169, 24},
+            {"minecraft:pink_concrete", 214, 101, 143},
+            {"minecraft:gray_concrete", 55, 58, 62},
+            {"minecraft:light_gray_concrete", 125, 125, 115},
+            {"minecraft:cyan_concrete", 21, 119, 136},
+            {"minecraft:purple_concrete", 100, 32, 156},
+            {"minecraft:blue_concrete", 45, 47, 143},
+            {"minecraft:brown_concrete", 96, 60, 32},
+            {"minecraft:green_concrete", 73, 91, 36},
+            {"minecraft:red_concrete", 142, 33, 33},
+            {"minecraft:black_concrete", 8, 10, 15},
+            {"minecraft:terracotta", 152, 94, 67},
+            {"minecraft:white_terracotta", 210, 178, 161},
+            {"minecraft:orange_terracotta", 162, 84, 38},
+            {"minecraft:magenta_terracotta", 150, 88, 109},
+            {"minecraft:light_blue_terracotta", 113, 109, 138},
+            {"minecraft:yellow_terracotta", 186, 133, 35},
+            {"minecraft:lime_terracotta", 104, 118, 53},
+            {"minecraft:pink_terracotta", 162, 78, 79},
+            {"minecraft:gray_terracotta", 58, 42, 36},
+            {"minecraft:light_gray_terracotta", 135, 107, 98},
+            {"minecraft:cyan_terracotta", 87, 91, 91},
+            {"minecraft:purple_terracotta", 118, 70, 86},
+            {"minecraft:blue_terracotta", 74, 60, 91},
+            {"minecraft:brown_terracotta", 77, 51, 36},
+            {"minecraft:green_terracotta", 76, 83, 42},
+            {"minecraft:red_terracotta", 143, 61, 47},
+            {"minecraft:black_terracotta", 37, 23, 16},
+        };
+    }
+
+    BlockPalette::BlockPalette() {
+    }
+
+    BlockPalette::~BlockPalette() {
+    }
+
+    int BlockPalette::blockIndexFor(const Color4& color) {
+        auto it = cache_.find(color);
+        if (it != cache_.end()) {
+            return it->second;
+        }
+
+        int best = 0;
+        int best_distance = INT_MAX;
+        for (int i = 0; i < static_cast<int>(std::size(kBlockColors)); ++i) {
+            int dr = color.r - kBlockColors[i].r;
+            int dg = color.g - kBlockColors[i].g;
+            int db = color.b - kBlockColors[i].b;
+            int distance = dr * dr + dg * dg + db * db;
+            if (distance < best_distance) {
+                best_distance = distance;
+                best = i;
+            }
+        }
+
+        cache_[color] = best;
+        return best;
+    }
+
+    const std::vector<std::string>& BlockPalette::getBlockNames() {
+        static const std::vector<std::string> names = [] {
+            std::vector<std::string> result;
+            for (const auto& block : kBlockColors) {
+                result.emplace_back(block.name);
+            }
+            return result;
+        }();
+        return names;
+    }
+}
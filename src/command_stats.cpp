@@ -0,0 +1,137 @@
+#include "command_stats.h"
+#include <climits>
+#include <algorithm>
+
+namespace obj2blocks {
+    CommandStats computeCommandStats(const std::vector<MinecraftCommand>&commands,
+                                     bool count_duplicates) {
+        CommandStats stats;
+
+        int minX = INT_MAX, minY = INT_MAX, minZ = INT_MAX;
+        int maxX = INT_MIN, maxY = INT_MIN, maxZ = INT_MIN;
+
+        for (const auto& cmd : commands) {
+            if (cmd.type == CommandType::CreateBlock) {
+                stats.total_blocks += 1;
+                stats.createblock_commands++;
+                minX = std::min(minX, cmd.position.x);
+                minY = std::min(minY, cmd.position.y);
+                minZ = std::min(minZ, cmd.position.z);
+                maxX = std::max(maxX, cmd.position.x);
+                maxY = std::max(maxY, cmd.position.y);
+                maxZ = std::max(maxZ, cmd.position.z);
+            } else {
+                stats.total_blocks += cmd.area.volume();
+                stats.fillarea_commands++;
+                minX = std::min(minX, cmd.area.min.x);
+                minY = std::min(minY, cmd.area.min.y);
+                minZ = std::min(minZ, cmd.area.min.z);
+                maxX = std::max(maxX, cmd.area.max.x);
+                maxY = std::max(maxY, cmd.area.max.y);
+                maxZ = std::max(maxZ, cmd.area.max.z);
+            }
+        }
+
+        stats.bounding_box = Box3i(Vec3i(minX, minY, minZ), Vec3i(maxX, maxY, maxZ));
+
+        if (count_duplicates) {
+            stats.duplicate_blocks = countDuplicateBlocks(commands);
+        }
+
+        return stats;
+    }
+
+    long long countDuplicateBlocks(const std::vector<MinecraftCommand>&commands) {
+        // Every placement beyond the first on a position is a duplicate, so the
+        // count equals total placements minus the volume of the union of all
+        // commands. The union is measured with a sweep along x: for each x slab
+        // the active commands contribute one z interval per y row, and the
+        // merged interval lengths give the slab's occupied cell count.
+        if (commands.empty()) return 0;
+
+        struct Span {
+            int min_x, max_x, min_y, max_y, min_z, max_z;
+        };
+        struct Row {
+            int y, z0, z1;
+
+            bool operator<(const Row&other) const {
+                if (y != other.y) return y < other.y;
+                return z0 < other.z0;
+            }
+        };
+
+        std::vector<Span> spans;
+        spans.reserve(commands.size());
+        long long total_placements = 0;
+        for (const auto&cmd: commands) {
+            if (cmd.type == CommandType::CreateBlock) {
+                const Vec3i&p = cmd.position;
+                spans.push_back({p.x, p.x, p.y, p.y, p.z, p.z});
+                total_placements += 1;
+            }
+            else {
+                const Box3i&b = cmd.area;
+                spans.push_back({b.min.x, b.max.x, b.min.y, b.max.y, b.min.z, b.max.z});
+                total_placements += static_cast<long long>(b.max.x - b.min.x + 1) *
+                        (b.max.y - b.min.y + 1) * (b.max.z - b.min.z + 1);
+            }
+        }
+
+        std::sort(spans.begin(), spans.end(), [](const Span&a, const Span&b) {
+            return a.min_x < b.min_x;
+        });
+
+        long long union_volume = 0;
+        std::vector<const Span*> active;
+        std::vector<Row> rows;
+        size_t next = 0;
+
+        int x = spans.front().min_x;
+
+        while (next < spans.size() || !active.empty()) {
+            // Jump over empty slabs straight to the next starting command
+            if (active.empty()) x = spans[next].min_x;
+
+            while (next < spans.size() && spans[next].min_x <= x) {
+                active.push_back(&spans[next++]);
+            }
+
+            // Slabs between x and the next event share the same active set
+            int slab_end = INT_MAX;
+            for (const Span* s: active) slab_end = std::min(slab_end, s->max_x);
+            if (next < spans.size()) slab_end = std::min(slab_end, spans[next].min_x - 1);
+
+            rows.clear();
+            for (const Span* s: active) {
+                for (int y = s->min_y; y <= s->max_y; ++y) {
+                    rows.push_back({y, s->min_z, s->max_z});
+                }
+            }
+            std::sort(rows.begin(), rows.end());
+
+            long long slab_area = 0;
+            for (size_t i = 0; i < rows.size();) {
+                int y = rows[i].y;
+                int z0 = rows[i].z0;
+                int z1 = rows[i].z1;
+                for (++i; i < rows.size() && rows[i].y == y; ++i) {
+                    if (rows[i].z0 > z1 + 1) {
+                        slab_area += static_cast<long long>(z1) - z0 + 1;
+                        z0 = rows[i].z0;
+                    }
+                    z1 = std::max(z1, rows[i].z1);
+                }
+                slab_area += static_cast<long long>(z1) - z0 + 1;
+            }
+            union_volume += slab_area * (static_cast<long long>(slab_end) - x + 1);
+
+            active.erase(std::remove_if(active.begin(), active.end(), [slab_end](const Span* s) {
+                return s->max_x <= slab_end;
+            }), active.end());
+            x = slab_end + 1;
+        }
+
+        return total_placements - union_volume;
+    }
+}
@@ -0,0 +1,163 @@
+#include "command_stream_reader.h"
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace obj2blocks {
+    namespace {
+        using json = nlohmann::json;
+
+        // SAX handler that materializes one command (or top-level member) at a time
+        class CommandSaxHandler : public nlohmann::json_sax<json> {
+        public:
+            CommandSaxHandler(const CommandStreamReader::CommandCallback&on_command,
+                              const CommandStreamReader::MemberCallback&on_member)
+                : on_command_(on_command), on_member_(on_member) {
+            }
+
+            bool null() override { return addValue(json(nullptr)); }
+            bool boolean(bool val) override { return addValue(json(val)); }
+            bool number_integer(number_integer_t val) override { return addValue(json(val)); }
+            bool number_unsigned(number_unsigned_t val) override { return addValue(json(val)); }
+            bool number_float(number_float_t val, const string_t&) override { return addValue(json(val)); }
+            bool string(string_t&val) override { return addValue(json(std::move(val))); }
+            bool binary(binary_t&val) override { return addValue(json(std::move(val))); }
+
+            bool start_object(std::size_t) override { return startContainer(json::object()); }
+            bool start_array(std::size_t) override { return startContainer(json::array()); }
+            bool end_object() override { return endContainer(); }
+            bool end_array() override { return endContainer(); }
+
+            bool key(string_t&val) override {
+                if (!capturing() && depth_ == 1) {
+                    top_key_ = val;
+                }
+                else {
+                    key_ = val;
+                }
+                return true;
+            }
+
+            bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception&ex) override {
+                std::cerr << "Error parsing JSON at byte " << position << ": " << ex.what() << std::endl;
+                return false;
+            }
+
+            bool hasCommandsArray() const { return has_commands_array_; }
+
+            size_t getCommandCount() const { return command_count_; }
+
+        private:
+            const CommandStreamReader::CommandCallback&on_command_;
+            const CommandStreamReader::MemberCallback&on_member_;
+
+            int depth_ = 0; // Number of open containers
+            bool in_commands_ = false;
+            bool has_commands_array_ = false;
+            size_t command_count_ = 0;
+            std::string top_key_;
+            std::string key_;
+            json value_;
+            std::vector<json*> stack_;
+
+            bool capturing() const { return !stack_.empty(); }
+
+            void deliver(json&&value) {
+                if (in_commands_) {
+                    command_count_++;
+                    on_command_(value);
+                }
+                else if (on_member_) {
+                    on_member_(top_key_, value);
+                }
+            }
+
+            bool addValue(json&&value) {
+                if (!capturing()) {
+                    // Scalars directly inside the root object or the commands array
+                    if (depth_ == 1 || (in_commands_ && depth_ == 2)) deliver(std::move(value));
+                    return true;
+                }
+                json* parent = stack_.back();
+                if (parent->is_object()) {
+                    (*parent)[key_] = std::move(value);
+                }
+                else {
+                    parent->push_back(std::move(value));
+                }
+                return true;
+            }
+
+            bool startContainer(json&&container) {
+                if (capturing()) {
+                    json* parent = stack_.back();
+                    if (parent->is_object()) {
+                        stack_.push_back(&((*parent)[key_] = std::move(container)));
+                    }
+                    else {
+                        parent->push_back(std::move(container));
+                        stack_.push_back(&parent->back());
+                    }
+                }
+                else if (depth_ == 1 && top_key_ == "commands" && container.is_array()) {
+                    in_commands_ = true;
+                    has_commands_array_ = true;
+                }
+                else if (depth_ == 1 || (in_commands_ && depth_ == 2)) {
+                    value_ = std::move(container);
+                    stack_.push_back(&value_);
+                }
+                depth_++;
+                return true;
+            }
+
+            bool endContainer() {
+                depth_--;
+                if (capturing()) {
+                    stack_.pop_back();
+                    if (!capturing()) {
+                        deliver(std::move(value_));
+                        value_ = json();
+                    }
+                }
+                else if (in_commands_ && depth_ == 1) {
+                    in_commands_ = false;
+                }
+                return true;
+            }
+        };
+    }
+
+    CommandStreamReader::CommandStreamReader() : has_commands_array_(false), command_count_(0) {
+    }
+
+    CommandStreamReader::~CommandStreamReader() {
+    }
+
+    bool CommandStreamReader::readFile(const std::string&filename, const CommandCallback&on_command,
+                                       const MemberCallback&on_member) {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Error: Cannot open input file " << filename << std::endl;
+            return false;
+        }
+        return readStream(file, on_command, on_member);
+    }
+
+    bool CommandStreamReader::readStream(std::istream&stream, const CommandCallback&on_command,
+                                         const MemberCallback&on_member) {
+        CommandSaxHandler handler(on_command, on_member);
+        bool ok = false;
+        try {
+            ok = nlohmann::json::sax_parse(stream, &handler);
+        }
+        catch (const std::exception&e) {
+            std::cerr << "Error processing JSON commands: " << e.what() << std::endl;
+            ok = false;
+        }
+
+        has_commands_array_ = handler.hasCommandsArray();
+        command_count_ = handler.getCommandCount();
+        return ok;
+    }
+}
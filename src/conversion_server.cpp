@@ -0,0 +1,465 @@
+#include "conversion_server.h"
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "json_exporter.h"
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace obj2blocks {
+    namespace {
+        // A client that never sends a newline must not grow the read buffer forever
+        constexpr size_t kMaxRequestBytes = 16 * 1024 * 1024;
+
+        std::string trim(const std::string&line) {
+            const char* whitespace = " \t\r\n";
+            size_t begin = line.find_first_not_of(whitespace);
+            if (begin == std::string::npos) return "";
+            return line.substr(begin, line.find_last_not_of(whitespace) - begin + 1);
+        }
+
+        nlohmann::json errorResponse(const nlohmann::json&id, const std::string&error) {
+            return {{"id", id}, {"ok", false}, {"error", error}};
+        }
+
+        // Paths and exception messages are not guaranteed to be valid UTF-8
+        std::string dumpLine(const nlohmann::json&json) {
+            return json.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+        }
+    }
+
+    ConversionServer::Channel::~Channel() {
+#ifndef _WIN32
+        if (fd >= 0) {
+            ::close(fd);
+        }
+#endif
+    }
+
+    void ConversionServer::Channel::send(const std::string&line) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stream) {
+            *stream << line << '\n' << std::flush;
+            return;
+        }
+#ifndef _WIN32
+        std::string framed = line + '\n';
+        size_t written = 0;
+        while (fd >= 0 && written < framed.size()) {
+            ssize_t n = ::write(fd, framed.data() + written, framed.size() - written);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break; // Client went away; its remaining responses are dropped
+            written += static_cast<size_t>(n);
+        }
+#endif
+    }
+
+    ConversionServer::ConversionServer(unsigned threads, const ConversionParams&texture_params)
+        : converter_(Converter::createTextureCache(texture_params)), pool_(threads), stopping_(false),
+          listen_fd_(-1), jobs_completed_(0), jobs_failed_(0) {
+        converter_.setMeshCache(std::make_shared<MeshCache>());
+        // Up to pool_ jobs decode at once; split the cores between them
+        converter_.setDecodeThreads(std::max(1u, resolveThreadCount(0) / pool_.getThreadCount()));
+    }
+
+    ConversionServer::~ConversionServer() {
+    }
+
+    void ConversionServer::setMeshCacheCapacity(size_t files) {
+        converter_.getMeshCache()->setCapacity(files);
+    }
+
+    void ConversionServer::setTextureCacheBytes(size_t bytes) {
+        converter_.getTextureCache()->setCapacityBytes(bytes);
+    }
+
+    int ConversionServer::serveStream(std::istream&in, std::ostream&out) {
+        auto channel = std::make_shared<Channel>();
+        channel->stream = &out;
+
+        std::string line;
+        while (!stopping_ && std::getline(in, line)) {
+            if (!handleLine(line, channel)) {
+                break;
+            }
+        }
+        // End of input still answers every request already accepted
+        pool_.wait();
+        return 0;
+    }
+
+    bool ConversionServer::handleLine(const std::string&raw_line, const std::shared_ptr<Channel>&channel) {
+        std::string line = trim(raw_line);
+        if (line.empty()) {
+            return true;
+        }
+
+        nlohmann::json request = nlohmann::json::parse(line, nullptr, false);
+        if (request.is_discarded() || !request.is_object()) {
+            channel->send(dumpLine(errorResponse(nullptr, "Request is not a JSON object")));
+            return true;
+        }
+        nlohmann::json id = request.contains("id") ? request["id"] : nlohmann::json();
+
+        auto op_it = request.find("op");
+        std::string op = "convert";
+        if (op_it != request.end()) {
+            if (!op_it->is_string()) {
+                channel->send(dumpLine(errorResponse(id, "\"op\" must be a string")));
+                return true;
+            }
+            op = op_it->get<std::string>();
+        }
+
+        if (op == "stats") {
+            channel->send(dumpLine({{"id", id}, {"ok", true}, {"stats", statsJson()}}));
+            return true;
+        }
+        if (op == "shutdown") {
+            // Refuse new work, finish what was accepted, then acknowledge
+            stopping_ = true;
+            pool_.wait();
+            channel->send(dumpLine({{"id", id}, {"ok", true}}));
+            requestShutdown();
+            return false;
+        }
+        if (op != "convert") {
+            channel->send(dumpLine(errorResponse(id, "Unknown op '" + op + "'")));
+            return true;
+        }
+        if (stopping_) {
+            channel->send(dumpLine(errorResponse(id, "Server is shutting down")));
+            return true;
+        }
+
+        pool_.submit([this, request = std::move(request), channel]() {
+            nlohmann::json response;
+            try {
+                response = runJob(request);
+            }
+            catch (const std::exception&e) {
+                response = errorResponse(request.contains("id") ? request["id"] : nlohmann::json(), e.what());
+            }
+            if (response["ok"].get<bool>()) {
+                jobs_completed_++;
+            }
+            else {
+                jobs_failed_++;
+            }
+            channel->send(dumpLine(response));
+        });
+        return true;
+    }
+
+    nlohmann::json ConversionServer::runJob(const nlohmann::json&request) {
+        nlohmann::json id = request.contains("id") ? request["id"] : nlohmann::json();
+
+        auto input_it = request.find("input");
+        if (input_it == request.end() || !input_it->is_string() || input_it->get<std::string>().empty()) {
+            return errorResponse(id, "\"input\" must name an OBJ file");
+        }
+
+        ConversionParams params;
+        std::string error;
+        if (!paramsFromJson(request.contains("params") ? request["params"] : nlohmann::json(), params, error)) {
+            return errorResponse(id, error);
+        }
+        params.input_file = input_it->get<std::string>();
+
+        std::string return_mode = "commands";
+        if (request.contains("output")) {
+            if (!request["output"].is_string() || request["output"].get<std::string>().empty()) {
+                return errorResponse(id, "\"output\" must be a file path");
+            }
+            params.output_file = request["output"].get<std::string>();
+        }
+        else if (request.contains("return")) {
+            if (!request["return"].is_string()) {
+                return errorResponse(id, "\"return\" must be a string");
+            }
+            return_mode = request["return"].get<std::string>();
+            if (return_mode != "commands" && return_mode != "voxels" && return_mode != "both" &&
+                return_mode != "none") {
+                return errorResponse(id, "\"return\" must be commands, voxels, both or none");
+            }
+        }
+
+        ConversionResult result;
+        if (!params.output_file.empty()) {
+            result = converter_.convert(params);
+        }
+        else {
+            MeshOutput output = return_mode == "voxels" ? MeshOutput::Voxels
+                                : return_mode == "both" ? MeshOutput::Both
+                                : MeshOutput::Commands;
+            result = converter_.convertToMemory(params, output);
+        }
+
+        if (!result.success) {
+            return errorResponse(id, result.error);
+        }
+
+        nlohmann::json response = {
+            {"id", id},
+            {"ok", true},
+            {"blocks", result.total_voxels},
+            {"commands", result.command_count},
+            {
+                "timings", {
+                    {"load", result.load_seconds},
+                    {"voxelize", result.voxelize_seconds},
+                    {"optimize", result.optimize_seconds},
+                    {"export", result.export_seconds},
+                    {"total", result.totalSeconds()}
+                }
+            }
+        };
+
+        if (return_mode == "commands" || return_mode == "both") {
+            if (params.output_file.empty()) {
+                // Same document a .json output file would hold
+                params.scale_factor = result.scale_factor;
+                response["result"] = JsonExporter().createJson(result.commands, params);
+            }
+        }
+        if (return_mode == "voxels" || return_mode == "both") {
+            nlohmann::json voxels = nlohmann::json::array();
+            for (const auto&voxel: result.voxels) {
+                voxels.push_back({
+                    voxel.position.x, voxel.position.y, voxel.position.z,
+                    voxel.color.r, voxel.color.g, voxel.color.b, voxel.color.a
+                });
+            }
+            response["voxels"] = std::move(voxels);
+        }
+        return response;
+    }
+
+    nlohmann::json ConversionServer::statsJson() const {
+        const auto&mesh_cache = converter_.getMeshCache();
+        const auto&texture_cache = converter_.getTextureCache();
+        return {
+            {"workers", pool_.getThreadCount()},
+            {"jobs_completed", jobs_completed_.load()},
+            {"jobs_failed", jobs_failed_.load()},
+            {
+                "mesh_cache", {
+                    {"entries", mesh_cache->size()},
+                    {"hits", mesh_cache->getHits()},
+                    {"misses", mesh_cache->getMisses()}
+                }
+            },
+            {
+                "texture_cache", {
+                    {"entries", texture_cache->size()},
+                    {"bytes", texture_cache->memoryBytes()}
+                }
+            }
+        };
+    }
+
+    bool ConversionServer::paramsFromJson(const nlohmann::json&json, ConversionParams&params, std::string&error) {
+        if (json.is_null()) {
+            return true;
+        }
+        if (!json.is_object()) {
+            error = "\"params\" must be an object";
+            return false;
+        }
+
+        static const char* known[] = {
+            "format", "size", "voxel_size", "scale", "solid", "optimize", "with_texture", "alpha_cutoff",
+            "duplicate_stats", "palette"
+        };
+        for (const auto&item: json.items()) {
+            if (std::none_of(std::begin(known), std::end(known),
+                             [&](const char* key) { return item.key() == key; })) {
+                error = "Unknown parameter '" + item.key() + "'";
+                return false;
+            }
+        }
+
+        try {
+            params.output_format = json.value("format", params.output_format);
+            params.target_size = json.value("size", params.target_size);
+            params.voxel_size = json.value("voxel_size", params.voxel_size);
+            if (json.contains("scale")) {
+                params.scale_factor = json["scale"].get<double>();
+                params.auto_scale = false;
+            }
+            params.solid = json.value("solid", params.solid);
+            params.optimize = json.value("optimize", params.optimize);
+            params.with_texture = json.value("with_texture", params.with_texture);
+            params.alpha_cutoff = json.value("alpha_cutoff", params.alpha_cutoff);
+            params.count_duplicates = json.value("duplicate_stats", params.count_duplicates);
+            params.palette_colors = json.value("palette", params.palette_colors);
+        }
+        catch (const nlohmann::json::exception&e) {
+            error = std::string("Invalid params: ") + e.what();
+            return false;
+        }
+
+        if (params.target_size <= 0.0 || params.voxel_size <= 0.0 || params.scale_factor <= 0.0) {
+            error = "size, voxel_size and scale must be positive";
+            return false;
+        }
+        if (params.alpha_cutoff < 0.0 || params.alpha_cutoff > 1.0) {
+            error = "alpha_cutoff must be between 0 and 1";
+            return false;
+        }
+        if (!params.output_format.empty() && !Converter::isSupportedFormat(params.output_format)) {
+            error = "Unknown output format '" + params.output_format + "'";
+            return false;
+        }
+        return true;
+    }
+
+    void ConversionServer::requestShutdown() {
+        stopping_ = true;
+#ifndef _WIN32
+        // Wakes the accept() loop in serveSocket
+        int fd = listen_fd_.load();
+        if (fd >= 0) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+#endif
+    }
+
+#ifndef _WIN32
+    void ConversionServer::readConnection(std::shared_ptr<Channel> channel) {
+        std::string buffer;
+        char chunk[4096];
+        bool open = true;
+        while (open) {
+            ssize_t n = ::read(channel->fd, chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                // A last request without a trailing newline still counts
+                if (!buffer.empty()) {
+                    handleLine(buffer, channel);
+                }
+                break;
+            }
+            buffer.append(chunk, static_cast<size_t>(n));
+
+            size_t start = 0;
+            size_t newline;
+            while ((newline = buffer.find('\n', start)) != std::string::npos) {
+                if (!handleLine(buffer.substr(start, newline - start), channel)) {
+                    open = false;
+                    break;
+                }
+                start = newline + 1;
+            }
+            buffer.erase(0, start);
+            if (open && buffer.size() > kMaxRequestBytes) {
+                channel->send(dumpLine(errorResponse(nullptr, "Request line too long")));
+                break;
+            }
+        }
+
+        // The descriptor closes once queued jobs for this client have replied
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        connections_.erase(std::remove(connections_.begin(), connections_.end(), channel), connections_.end());
+        active_readers_--;
+        readers_done_.notify_all();
+    }
+
+    int ConversionServer::serveSocket(const std::string&path) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) {
+            std::cerr << "Error: Socket path is too long: " << path << std::endl;
+            return 1;
+        }
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+        // Writes to a client that hung up must fail instead of killing the server
+        std::signal(SIGPIPE, SIG_IGN);
+
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            std::cerr << "Error: Failed to create socket: " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        // A socket left behind by a run that did not shut down cleanly is replaced;
+        // anything else at the path is somebody's file and is left alone
+        struct stat existing;
+        if (::lstat(path.c_str(), &existing) == 0) {
+            if (!S_ISSOCK(existing.st_mode)) {
+                std::cerr << "Error: " << path << " exists and is not a socket; refusing to replace it" << std::endl;
+                ::close(fd);
+                return 1;
+            }
+            ::unlink(path.c_str());
+        }
+        struct stat created;
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(fd, SOMAXCONN) != 0 || ::lstat(path.c_str(), &created) != 0) {
+            std::cerr << "Error: Failed to listen on " << path << ": " << std::strerror(errno) << std::endl;
+            ::close(fd);
+            return 1;
+        }
+        listen_fd_ = fd;
+        std::cerr << "Listening on " << path << " with " << pool_.getThreadCount() << " workers" << std::endl;
+
+        while (!stopping_) {
+            int client = ::accept(fd, nullptr, nullptr);
+            if (client < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                if (!stopping_) {
+                    std::cerr << "Error: accept failed: " << std::strerror(errno) << std::endl;
+                }
+                break;
+            }
+
+            auto channel = std::make_shared<Channel>();
+            channel->fd = client;
+            {
+                std::lock_guard<std::mutex> lock(connections_mutex_);
+                connections_.push_back(channel);
+                active_readers_++;
+            }
+            std::thread(&ConversionServer::readConnection, this, channel).detach();
+        }
+        stopping_ = true;
+
+        // Stop reading from the remaining clients; their accepted jobs still reply
+        {
+            std::unique_lock<std::mutex> lock(connections_mutex_);
+            for (const auto&connection: connections_) {
+                ::shutdown(connection->fd, SHUT_RD);
+            }
+            readers_done_.wait(lock, [this] { return active_readers_ == 0; });
+        }
+        pool_.wait();
+
+        listen_fd_ = -1;
+        ::close(fd);
+        // Only if the path still names the socket this server created
+        struct stat current;
+        if (::lstat(path.c_str(), &current) == 0 && S_ISSOCK(current.st_mode) &&
+            current.st_dev == created.st_dev && current.st_ino == created.st_ino) {
+            ::unlink(path.c_str());
+        }
+        return 0;
+    }
+#else
+    void ConversionServer::readConnection(std::shared_ptr<Channel> channel) {
+    }
+
+    int ConversionServer::serveSocket(const std::string&path) {
+        std::cerr << "Error: --socket needs Unix domain sockets, which this platform does not provide; "
+                  << "serve over stdin/stdout instead" << std::endl;
+        return 1;
+    }
+#endif
+}
@@ -0,0 +1,405 @@
+#include "converter.h"
+#include <iostream>
+#include <chrono>
+#include <exception>
+#include <set>
+#include <algorithm>
+
+#include "mesh_processor.h"
+#include "voxelizer.h"
+#include "block_optimizer.h"
+#include "json_exporter.h"
+#include "binary_exporter.h"
+#include "mcfunction_exporter.h"
+#include "schematic_exporter.h"
+
+namespace obj2blocks {
+    namespace {
+        bool hasExtension(const std::string&path, const std::string&extension) {
+            return path.size() >= extension.size() &&
+                   path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+        }
+
+        const char* const kOutputFormats[] = {"json", "o2b", "mcfunction", "schem", "nbt"};
+
+        double secondsSince(std::chrono::steady_clock::time_point start) {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+
+    Converter::Converter() : texture_cache_(std::make_shared<TextureCache>()) {
+    }
+
+    Converter::Converter(std::shared_ptr<TextureCache> texture_cache)
+        : texture_cache_(texture_cache ? std::move(texture_cache) : std::make_shared<TextureCache>()) {
+    }
+
+    Converter::~Converter() {
+    }
+
+    std::shared_ptr<TextureCache> Converter::createTextureCache(const ConversionParams&params) {
+        auto texture_cache = std::make_shared<TextureCache>();
+        texture_cache->setGenerateMipmaps(params.with_texture && params.mipmaps);
+        texture_cache->setTiledLayout(params.with_texture && params.tiled_textures);
+        return texture_cache;
+    }
+
+    std::string Converter::resolveOutputFormat(const ConversionParams&params) {
+        if (!params.output_format.empty()) return params.output_format;
+        for (const char* format : kOutputFormats) {
+            if (hasExtension(params.output_file, std::string(".") + format)) return format;
+        }
+        return "json";
+    }
+
+    bool Converter::isSupportedFormat(const std::string&format) {
+        return std::find(std::begin(kOutputFormats), std::end(kOutputFormats), format) != std::end(kOutputFormats);
+    }
+
+    bool Converter::exportCommands(const ConversionParams&params, const std::vector<MinecraftCommand>&commands) {
+        std::string format = resolveOutputFormat(params);
+
+        if (format == "json") {
+            JsonExporter exporter;
+            std::cout << "\nExporting to JSON...\n";
+            return exporter.exportToFile(params.output_file, commands, params);
+        }
+        if (format == "o2b") {
+            BinaryExporter exporter;
+            std::cout << "\nExporting to binary command stream...\n";
+            return exporter.exportToFile(params.output_file, commands, params);
+        }
+        if (format == "mcfunction") {
+            McfunctionExporter exporter;
+            std::cout << "\nExporting to mcfunction...\n";
+            return exporter.exportToFile(params.output_file, commands);
+        }
+        if (format == "schem") {
+            SchematicExporter exporter;
+            std::cout << "\nExporting to Sponge schematic...\n";
+            return exporter.exportSchematic(params.output_file, commands);
+        }
+        if (format == "nbt") {
+            SchematicExporter exporter;
+            std::cout << "\nExporting to structure NBT...\n";
+            return exporter.exportStructure(params.output_file, commands);
+        }
+
+        std::cerr << "Error: Unknown output format '" << format << "'" << std::endl;
+        return false;
+    }
+
+    ConversionResult Converter::convert(const ConversionParams&input_params, Profiler* profiler) const {
+        ConversionResult result;
+        ConversionParams params = input_params;
+
+        // One bad asset must not take the rest of a batch down with it
+        try {
+            auto stage_start = std::chrono::steady_clock::now();
+            MeshProcessor processor;
+            if (!loadFile(params, processor, result, profiler)) {
+                result.error = "Failed to load OBJ file";
+                return result;
+            }
+            result.load_seconds = secondsSince(stage_start);
+
+            std::vector<MinecraftCommand> commands;
+            if (!process(processor, params, MeshOutput::Commands, result, commands, profiler)) {
+                return result;
+            }
+
+            stage_start = std::chrono::steady_clock::now();
+            {
+                Profiler::Scope scope(profiler, "export");
+                if (!exportCommands(params, commands)) {
+                    result.error = "Failed to export " + params.output_file;
+                    return result;
+                }
+            }
+            result.export_seconds = secondsSince(stage_start);
+        }
+        catch (const std::exception&e) {
+            result.error = e.what();
+            return result;
+        }
+        catch (...) {
+            result.error = "Unknown exception";
+            return result;
+        }
+
+        result.success = true;
+        return result;
+    }
+
+    ConversionResult Converter::convertToMemory(const ConversionParams&input_params, MeshOutput output,
+                                                Profiler* profiler) const {
+        ConversionResult result;
+        ConversionParams params = input_params;
+
+        try {
+            auto stage_start = std::chrono::steady_clock::now();
+            MeshProcessor processor;
+            if (!loadFile(params, processor, result, profiler)) {
+                result.error = "Failed to load OBJ file";
+                return result;
+            }
+            result.load_seconds = secondsSince(stage_start);
+
+            if (!process(processor, params, output, result, result.commands, profiler)) {
+                return result;
+            }
+        }
+        catch (const std::exception&e) {
+            result.error = e.what();
+            return result;
+        }
+        catch (...) {
+            result.error = "Unknown exception";
+            return result;
+        }
+
+        result.success = true;
+        return result;
+    }
+
+    bool Converter::loadFile(const ConversionParams&params, MeshProcessor&processor, ConversionResult&result,
+                             Profiler* profiler) const {
+        processor.setTextureCache(texture_cache_);
+        processor.setProfiler(profiler);
+        processor.setDecodeThreads(decode_threads_);
+        std::cout << "Loading OBJ file...\n";
+
+        if (mesh_cache_) {
+            std::shared_ptr<const ObjLoader> cached;
+            {
+                Profiler::Scope scope(profiler, "parse");
+                cached = mesh_cache_->get(params.input_file, texture_cache_, params.with_texture, decode_threads_,
+                                          &result.textures_decoded);
+            }
+            // Shared with other requests; the processor only reads it
+            if (cached && processor.loadFromLoader(std::move(cached))) {
+                return true;
+            }
+        }
+        bool loaded = processor.loadOBJ(params.input_file, params.with_texture);
+        result.textures_decoded = processor.getTexturesDecoded();
+        return loaded;
+    }
+
+    ConversionResult Converter::convertMesh(const MeshInput&mesh, const ConversionParams&input_params,
+                                            MeshOutput output, Profiler* profiler) const {
+        ConversionResult result;
+        ConversionParams params = input_params;
+
+        try {
+            auto stage_start = std::chrono::steady_clock::now();
+            std::unique_ptr<ObjLoader> loader;
+            {
+                Profiler::Scope scope(profiler, "parse");
+                loader = buildLoader(mesh, result);
+            }
+            if (!loader) {
+                return result;
+            }
+
+            MeshProcessor processor;
+            processor.setProfiler(profiler);
+            if (!processor.loadFromLoader(std::move(loader))) {
+                result.error = "Mesh has no usable triangles";
+                return result;
+            }
+            result.load_seconds = secondsSince(stage_start);
+
+            if (!process(processor, params, output, result, result.commands, profiler)) {
+                return result;
+            }
+        }
+        catch (const std::exception&e) {
+            result.error = e.what();
+            return result;
+        }
+        catch (...) {
+            result.error = "Unknown exception";
+            return result;
+        }
+
+        result.success = true;
+        return result;
+    }
+
+    std::unique_ptr<ObjLoader> Converter::buildLoader(const MeshInput&mesh, ConversionResult&result) const {
+        std::string&error = result.error;
+        const size_t vertex_count = mesh.vertexCount();
+        const size_t triangle_count = mesh.triangleCount();
+        if (mesh.positions.size() % 3 != 0 || mesh.indices.size() % 3 != 0) {
+            error = "positions and indices must hold three values per vertex / triangle";
+            return nullptr;
+        }
+        if (!mesh.uvs.empty() && mesh.uvs.size() != vertex_count * 2) {
+            error = "uvs must hold two values per vertex";
+            return nullptr;
+        }
+        if (!mesh.colors.empty() && mesh.colors.size() != vertex_count * 4) {
+            error = "colors must hold four values per vertex";
+            return nullptr;
+        }
+        if (!mesh.triangle_materials.empty() && mesh.triangle_materials.size() != triangle_count) {
+            error = "triangle_materials must hold one value per triangle";
+            return nullptr;
+        }
+
+        auto loader = std::make_unique<ObjLoader>(texture_cache_);
+        for (size_t v = 0; v < vertex_count; ++v) {
+            pmp::Point position(mesh.positions[3 * v], mesh.positions[3 * v + 1], mesh.positions[3 * v + 2]);
+            if (mesh.colors.empty()) {
+                loader->addVertex(position);
+            }
+            else {
+                const uint8_t* c = &mesh.colors[4 * v];
+                loader->addVertex(position, Color4(c[0], c[1], c[2], c[3]));
+            }
+        }
+        for (size_t v = 0; v * 2 < mesh.uvs.size(); ++v) {
+            loader->addUV(Vec2f(mesh.uvs[2 * v], mesh.uvs[2 * v + 1]));
+        }
+
+        // Materials keep their texture paths; the images come from mesh.textures
+        for (Material material: mesh.materials) {
+            for (const std::string* path: {&material.diffuse_texture_path, &material.emissive_texture_path,
+                                           &material.opacity_texture_path}) {
+                if (path->empty() || material.textures.count(*path)) continue;
+                auto it = mesh.textures.find(*path);
+                if (it == mesh.textures.end()) {
+                    std::cerr << "Warning: texture '" << *path << "' of material '" << material.name
+                              << "' was not supplied" << std::endl;
+                    continue;
+                }
+                if (it->second.decoded) {
+                    material.textures[*path] = it->second.decoded;
+                    continue;
+                }
+                bool decoded = false;
+                material.textures[*path] = texture_cache_->getFromMemory(it->second.encoded, &decoded);
+                result.textures_decoded += decoded ? 1 : 0;
+            }
+            loader->getMaterialLoader().addMaterial(std::move(material));
+        }
+
+        for (size_t t = 0; t < triangle_count; ++t) {
+            FaceData face;
+            for (size_t k = 0; k < 3; ++k) {
+                uint32_t index = mesh.indices[3 * t + k];
+                if (index >= vertex_count) {
+                    error = "triangle " + std::to_string(t) + " references vertex " + std::to_string(index) +
+                            " of " + std::to_string(vertex_count);
+                    return nullptr;
+                }
+                face.vertex_indices.push_back(static_cast<int>(index));
+                face.uv_indices.push_back(mesh.uvs.empty() ? -1 : static_cast<int>(index));
+            }
+            if (!mesh.triangle_materials.empty() && mesh.triangle_materials[t] >= 0) {
+                size_t material = static_cast<size_t>(mesh.triangle_materials[t]);
+                if (material >= mesh.materials.size()) {
+                    error = "triangle " + std::to_string(t) + " uses missing material " + std::to_string(material);
+                    return nullptr;
+                }
+                face.material_name = mesh.materials[material].name;
+            }
+            loader->addFace(face);
+        }
+        return loader;
+    }
+
+    bool Converter::process(MeshProcessor&processor, ConversionParams&params, MeshOutput output,
+                            ConversionResult&result, std::vector<MinecraftCommand>&commands,
+                            Profiler* profiler) const {
+        auto stage_start = std::chrono::steady_clock::now();
+        if (profiler) {
+            profiler->setCounter("vertices", processor.getMesh().n_vertices());
+            profiler->setCounter("triangles", processor.getMesh().n_faces());
+            profiler->setCounter("textures_decoded", result.textures_decoded);
+        }
+
+        {
+            Profiler::Scope scope(profiler, "center_scale");
+            processor.centerMesh();
+
+            if (params.auto_scale) {
+                processor.autoScale(params.target_size);
+                params.scale_factor = params.target_size / processor.getMaxDimension();
+            }
+            else {
+                processor.scaleMesh(params.scale_factor);
+            }
+        }
+        result.scale_factor = params.scale_factor;
+        result.load_seconds += secondsSince(stage_start);
+
+        Voxelizer voxelizer(params.voxel_size);
+        voxelizer.setAlphaCutoff(params.alpha_cutoff);
+        voxelizer.setProfiler(profiler);
+        BlockOptimizer optimizer;
+        optimizer.setOptimizationEnabled(params.optimize);
+        const bool optimize = output != MeshOutput::Voxels;
+        const bool keep_voxels = output != MeshOutput::Commands;
+        std::cout << "\nStarting voxelization...\n";
+
+        // Vertex-coloured OBJs always use their colours; materials need --with-texture
+        stage_start = std::chrono::steady_clock::now();
+        if (processor.hasObjLoader() && (params.with_texture || processor.getObjLoader().hasVertexColors())) {
+            // Use material-aware voxelization
+            std::set<VoxelData> voxels_with_colors = voxelizer.voxelizeWithMaterials(processor, params.solid);
+            result.voxelize_seconds = secondsSince(stage_start);
+            result.total_voxels = voxels_with_colors.size();
+            if (profiler) {
+                std::set<Color4> colors;
+                for (const auto&voxel: voxels_with_colors) {
+                    colors.insert(voxel.color);
+                }
+                profiler->setCounter("colors", colors.size());
+            }
+
+            if (optimize && !voxels_with_colors.empty()) {
+                Profiler::Scope scope(profiler, "optimize");
+                stage_start = std::chrono::steady_clock::now();
+                std::cout << "\nOptimizing block placement with colors...\n";
+                commands = optimizer.optimizeWithColors(voxels_with_colors);
+                result.optimize_seconds = secondsSince(stage_start);
+            }
+            if (keep_voxels) {
+                result.voxels.assign(voxels_with_colors.begin(), voxels_with_colors.end());
+            }
+        }
+        else {
+            // Fallback to simple voxelization
+            std::set<Vec3i> voxels = voxelizer.voxelize(processor.getMesh(), params.solid);
+            result.voxelize_seconds = secondsSince(stage_start);
+            result.total_voxels = voxels.size();
+
+            if (optimize && !voxels.empty()) {
+                Profiler::Scope scope(profiler, "optimize");
+                stage_start = std::chrono::steady_clock::now();
+                std::cout << "\nOptimizing block placement...\n";
+                commands = optimizer.optimize(voxels);
+                result.optimize_seconds = secondsSince(stage_start);
+            }
+            if (keep_voxels) {
+                result.voxels.reserve(voxels.size());
+                for (const auto&voxel: voxels) {
+                    result.voxels.emplace_back(voxel, Color4());
+                }
+            }
+        }
+
+        if (result.total_voxels == 0) {
+            result.error = "No voxels generated from the model";
+            return false;
+        }
+        result.command_count = commands.size();
+        if (profiler) {
+            profiler->setCounter("voxels", result.total_voxels);
+            profiler->setCounter("commands", result.command_count);
+        }
+        return true;
+    }
+}
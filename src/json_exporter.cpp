@@ -1,8 +1,7 @@
 #include "json_exporter.h"
+#include "command_stats.h"
 #include <fstream>
 #include <iostream>
-#include <climits>
-#include <algorithm>
 #include <map>
 
 namespace obj2blocks {
@@ -24,10 +23,10 @@ namespace obj2blocks {
                 return false;
             }
 
-            file << json.dump(2);
+            writeDocument(file, json);
             file.close();
 
-            std::cout << "Successfully exported to: " << filename << std::endl;
+            std::cout << "Successfully exported to: " << filename << '\n';
             return true;
         }
         catch (const std::exception&e) {
@@ -47,86 +46,84 @@ namespace obj2blocks {
         json["model_info"]["auto_scale"] = params.auto_scale;
         json["model_info"]["solid_fill"] = params.solid;
         json["model_info"]["optimization_enabled"] = params.optimize;
-        json["model_info"]["total_blocks"] = countTotalBlocks(commands);
+
+        CommandStats stats = computeCommandStats(commands, params.count_duplicates);
+        const Box3i&bbox = stats.bounding_box;
+
+        json["model_info"]["total_blocks"] = stats.total_blocks;
         json["model_info"]["total_commands"] = commands.size();
-        
-        // Calculate bounding box
-        int minX = INT_MAX, minY = INT_MAX, minZ = INT_MAX;
-        int maxX = INT_MIN, maxY = INT_MIN, maxZ = INT_MIN;
-        
-        for (const auto& cmd : commands) {
-            if (cmd.type == CommandType::CreateBlock) {
-                minX = std::min(minX, cmd.position.x);
-                minY = std::min(minY, cmd.position.y);
-                minZ = std::min(minZ, cmd.position.z);
-                maxX = std::max(maxX, cmd.position.x);
-                maxY = std::max(maxY, cmd.position.y);
-                maxZ = std::max(maxZ, cmd.position.z);
-            } else {
-                minX = std::min(minX, cmd.area.min.x);
-                minY = std::min(minY, cmd.area.min.y);
-                minZ = std::min(minZ, cmd.area.min.z);
-                maxX = std::max(maxX, cmd.area.max.x);
-                maxY = std::max(maxY, cmd.area.max.y);
-                maxZ = std::max(maxZ, cmd.area.max.z);
-            }
-        }
-        
+
         // Add bounding box info
-        json["model_info"]["bounding_box"]["min"] = {minX, minY, minZ};
-        json["model_info"]["bounding_box"]["max"] = {maxX, maxY, maxZ};
+        json["model_info"]["bounding_box"]["min"] = {bbox.min.x, bbox.min.y, bbox.min.z};
+        json["model_info"]["bounding_box"]["max"] = {bbox.max.x, bbox.max.y, bbox.max.z};
         json["model_info"]["bounding_box"]["size"] = {
-            maxX - minX + 1,
-            maxY - minY + 1,
-            maxZ - minZ + 1
+            bbox.max.x - bbox.min.x + 1,
+            bbox.max.y - bbox.min.y + 1,
+            bbox.max.z - bbox.min.z + 1
         };
 
-        int fillarea_count = 0;
-        int createblock_count = 0;
-
         nlohmann::json commands_array = nlohmann::json::array();
-        for (const auto&cmd: commands) {
-            commands_array.push_back(commandToJson(cmd));
-            if (cmd.type == CommandType::FillArea) {
-                fillarea_count++;
-            }
-            else {
-                createblock_count++;
-            }
-        }
-
-        // Compute duplicate blocks placed at the same position
-        // We count how many extra placements happen on already-occupied positions.
-        // Implementation note: uses std::map with Vec3i::operator< defined in types.h
-        long long duplicate_blocks = 0;
-        {
-            std::map<Vec3i, int> freq;
-            for (const auto& cmd : commands) {
-                if (cmd.type == CommandType::CreateBlock) {
-                    freq[cmd.position] += 1;
-                } else { // FillArea
-                    for (int x = cmd.area.min.x; x <= cmd.area.max.x; ++x) {
-                        for (int y = cmd.area.min.y; y <= cmd.area.max.y; ++y) {
-                            for (int z = cmd.area.min.z; z <= cmd.area.max.z; ++z) {
-                                freq[{x, y, z}] += 1;
-                            }
-                        }
-                    }
+        if (params.palette_colors) {
+            // Schema v2: commands reference colours in a top-level palette
+            std::map<Color4, int> palette_index;
+            nlohmann::json palette = nlohmann::json::array();
+            for (const auto&cmd: commands) {
+                auto [it, inserted] = palette_index.emplace(cmd.color, static_cast<int>(palette.size()));
+                if (inserted) {
+                    palette.push_back({cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a});
                 }
+                nlohmann::json json_cmd = commandToJson(cmd);
+                json_cmd["color"] = it->second;
+                commands_array.push_back(std::move(json_cmd));
             }
-            for (const auto& kv : freq) {
-                if (kv.second > 1) duplicate_blocks += static_cast<long long>(kv.second - 1);
+            json["model_info"]["schema_version"] = 2;
+            json["palette"] = std::move(palette);
+        }
+        else {
+            for (const auto&cmd: commands) {
+                commands_array.push_back(commandToJson(cmd));
             }
         }
 
-        json["model_info"]["fillarea_commands"] = fillarea_count;
-        json["model_info"]["createblock_commands"] = createblock_count;
-        json["model_info"]["duplicate_blocks"] = duplicate_blocks;
+        json["model_info"]["fillarea_commands"] = stats.fillarea_commands;
+        json["model_info"]["createblock_commands"] = stats.createblock_commands;
+        if (params.count_duplicates) {
+            json["model_info"]["duplicate_blocks"] = stats.duplicate_blocks;
+        }
         json["commands"] = commands_array;
 
         return json;
     }
 
+    void JsonExporter::writeDocument(std::ostream&out, const nlohmann::json&json) {
+        // Same layout as dump(2), but model_info and palette are written ahead of
+        // commands so streaming readers see them before the first command.
+        std::vector<std::string> keys;
+        for (const char* key: {"model_info", "palette"}) {
+            if (json.contains(key)) keys.emplace_back(key);
+        }
+        for (const auto&[key, value]: json.items()) {
+            if (key != "model_info" && key != "palette") keys.push_back(key);
+        }
+
+        out << "{\n";
+        for (size_t i = 0; i < keys.size(); ++i) {
+            const std::string value = json[keys[i]].dump(2);
+            out << "  " << nlohmann::json(keys[i]).dump() << ": ";
+            // Nest one level deeper, copying the lines between newlines in one pass;
+            // dumped strings never contain raw newlines
+            size_t start = 0;
+            for (size_t pos = value.find('\n'); pos != std::string::npos; pos = value.find('\n', start)) {
+                out.write(value.data() + start, static_cast<std::streamsize>(pos - start));
+                out << "\n  ";
+                start = pos + 1;
+            }
+            out.write(value.data() + start, static_cast<std::streamsize>(value.size() - start));
+            out << (i + 1 < keys.size() ? ",\n" : "\n");
+        }
+        out << "}";
+    }
+
     nlohmann::json JsonExporter::commandToJson(const MinecraftCommand&cmd) {
         nlohmann::json json_cmd;
 
@@ -145,17 +142,4 @@ namespace obj2blocks {
 
         return json_cmd;
     }
-
-    int JsonExporter::countTotalBlocks(const std::vector<MinecraftCommand>&commands) {
-        int total = 0;
-        for (const auto&cmd: commands) {
-            if (cmd.type == CommandType::CreateBlock) {
-                total += 1;
-            }
-            else {
-                total += cmd.area.volume();
-            }
-        }
-        return total;
-    }
 }
@@ -1,17 +1,138 @@
 #include <iostream>
 #include <string>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <mutex>
+#include <algorithm>
 #include <cxxopts.hpp>
 
-#include "mesh_processor.h"
-#include "voxelizer.h"
-#include "block_optimizer.h"
-#include "json_exporter.h"
+#include "converter.h"
+#include "conversion_server.h"
+#include "binary_reader.h"
+#include "command_stream_reader.h"
 #include "types.h"
 #include "ObjGenerator.h"
+#include "thumbnail_renderer.h"
+#include "parallel.h"
 
 using namespace obj2blocks;
 
+struct ManifestEntry {
+    std::string input;
+    std::string output;
+};
+
+// One "input output" pair per line; quote paths with spaces, '#' starts a comment
+static bool readManifest(const std::string& path, std::vector<ManifestEntry>& entries) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open batch manifest: " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        std::istringstream iss(line);
+        ManifestEntry entry;
+        if (!(iss >> std::quoted(entry.input)) || entry.input[0] == '#') {
+            continue;
+        }
+        if (!(iss >> std::quoted(entry.output))) {
+            std::cerr << "Error: " << path << ":" << line_number << ": expected an input and an output path" << std::endl;
+            return false;
+        }
+        entries.push_back(std::move(entry));
+    }
+    return true;
+}
+
+// Swallows std::cout for --quiet and while concurrent batch jobs would interleave it
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+static int runBatch(const ConversionParams& params, const std::string& manifest, unsigned jobs, bool quiet) {
+    std::vector<ManifestEntry> entries;
+    if (!readManifest(manifest, entries)) {
+        return 1;
+    }
+    if (entries.empty()) {
+        std::cerr << "Error: Batch manifest " << manifest << " lists no files" << std::endl;
+        return 1;
+    }
+
+    // Every job shares one texture cache, so libraries used by many assets decode once
+    Converter converter(Converter::createTextureCache(params));
+    std::vector<ConversionResult> results(entries.size());
+    unsigned workers = static_cast<unsigned>(std::min<size_t>(resolveThreadCount(jobs), entries.size()));
+    // The jobs already keep every core busy; split the cores for texture decoding between them
+    converter.setDecodeThreads(std::max(1u, resolveThreadCount(0) / workers));
+    std::cout << "Batch: " << entries.size() << " files on " << workers << " workers\n";
+
+    NullBuffer null_buffer;
+    std::ostream console(std::cout.rdbuf(&null_buffer));
+    std::mutex console_mutex;
+    size_t finished = 0;
+    auto batch_start = std::chrono::steady_clock::now();
+
+    parallelFor(entries.size(), workers, [&](size_t i) {
+        ConversionParams job = params;
+        job.input_file = entries[i].input;
+        job.output_file = entries[i].output;
+        results[i] = converter.convert(job);
+
+        std::lock_guard<std::mutex> lock(console_mutex);
+        finished++;
+        if (quiet && results[i].success) {
+            return;
+        }
+        console << "[" << finished << "/" << entries.size() << "] ";
+        if (results[i].success) {
+            console << "ok " << job.input_file << " -> " << job.output_file << std::endl;
+        } else {
+            console << "FAILED " << job.input_file << ": " << results[i].error << std::endl;
+        }
+    });
+
+    double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - batch_start).count();
+    std::cout.rdbuf(console.rdbuf());
+
+    std::cout << "\n=== Batch Summary ===\n";
+    std::cout << std::left << std::setw(6) << "#" << std::setw(8) << "status" << std::right
+              << std::setw(10) << "blocks" << std::setw(10) << "commands"
+              << std::setw(9) << "load" << std::setw(9) << "voxel" << std::setw(9) << "optim"
+              << std::setw(9) << "export" << std::setw(9) << "total" << "  input\n";
+
+    size_t failed = 0;
+    size_t textures_decoded = 0;
+    double job_seconds = 0.0;
+    std::cout << std::fixed << std::setprecision(3);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const ConversionResult& r = results[i];
+        if (!r.success) failed++;
+        textures_decoded += r.textures_decoded;
+        job_seconds += r.totalSeconds();
+        std::cout << std::left << std::setw(6) << i + 1 << std::setw(8) << (r.success ? "ok" : "FAILED") << std::right
+                  << std::setw(10) << r.total_voxels << std::setw(10) << r.command_count
+                  << std::setw(9) << r.load_seconds << std::setw(9) << r.voxelize_seconds
+                  << std::setw(9) << r.optimize_seconds << std::setw(9) << r.export_seconds
+                  << std::setw(9) << r.totalSeconds() << "  " << entries[i].input << '\n';
+    }
+
+    std::cout << "\nConverted: " << entries.size() - failed << "/" << entries.size()
+              << " (" << failed << " failed)\n";
+    std::cout << "Wall time: " << wall_seconds << " s, summed job time: " << job_seconds << " s\n";
+    std::cout << "Textures decoded: " << textures_decoded << '\n';
+    std::cout << std::defaultfloat;
+
+    return failed == 0 ? 0 : 1;
+}
+
 int obj2blocks_main(int argc, char* argv[]) {
     ConversionParams params;
 
@@ -19,31 +140,59 @@ int obj2blocks_main(int argc, char* argv[]) {
 
     options.add_options()
             ("i,input", "Input OBJ file", cxxopts::value<std::string>())
-            ("o,output", "Output JSON file", cxxopts::value<std::string>())
+            ("o,output", "Output file (.json, .o2b, .mcfunction, .schem or .nbt)", cxxopts::value<std::string>())
+            ("format", "Output format: json, o2b, mcfunction, schem or nbt (default: from output extension)", cxxopts::value<std::string>())
             ("s,size", "Target size for largest dimension", cxxopts::value<double>()->default_value("200"))
             ("v,voxel-size", "Voxel size", cxxopts::value<double>()->default_value("1.0"))
             ("scale", "Manual scale factor (disables auto-scale)", cxxopts::value<double>())
             ("surface", "Only voxelize surface (no interior fill)", cxxopts::value<bool>()->default_value("true"))
             ("optimize", "Enable fillarea optimization", cxxopts::value<bool>()->default_value("false"))
             ("with-texture", "Use texture mapping for block colors (if available)", cxxopts::value<bool>()->default_value("false"))
+            ("mipmaps", "Sample textures from the mip level matching each voxel's footprint", cxxopts::value<bool>()->default_value("false"))
+            ("tiled-textures", "Store textures in cache-friendly 8x8 RGBA tiles", cxxopts::value<bool>()->default_value("false"))
+            ("alpha-cutoff", "Drop texture samples and voxels with opacity below this (0-1, 0 = keep all)", cxxopts::value<double>()->default_value("0"))
+            ("duplicate-stats", "Compute the duplicate_blocks statistic", cxxopts::value<bool>()->default_value("true"))
+            ("palette", "Write JSON schema v2 with a colour palette and per-command colour indices", cxxopts::value<bool>()->default_value("false"))
+            ("batch", "Convert every 'input output' pair in this manifest, sharing caches (replaces -i/-o)", cxxopts::value<std::string>())
+            ("j,jobs", "Files converted concurrently in --batch mode (0 = all cores)", cxxopts::value<unsigned>()->default_value("0"))
+            ("profile", "Write per-stage wall/CPU time, peak RSS and counters to this JSON report", cxxopts::value<std::string>())
+            ("q,quiet", "Suppress progress output (errors are still reported)", cxxopts::value<bool>()->default_value("false"))
             ("h,help", "Show this help message");
 
+    std::string batch_manifest;
+    unsigned batch_jobs = 0;
+    std::string profile_file;
+    bool quiet = false;
+
     try {
         auto result = options.parse(argc, argv);
 
         if (result.count("help")) {
-            std::cout << options.help() << std::endl;
+            std::cout << options.help() << '\n';
             return 0;
         }
 
-        if (!result.count("input") || !result.count("output")) {
+        if (result.count("batch")) {
+            batch_manifest = result["batch"].as<std::string>();
+            batch_jobs = result["jobs"].as<unsigned>();
+        }
+        else if (!result.count("input") || !result.count("output")) {
             std::cerr << "Error: Input and output files are required.\n\n";
-            std::cout << options.help() << std::endl;
+            std::cout << options.help() << '\n';
             return 1;
         }
-
-        params.input_file = result["input"].as<std::string>();
-        params.output_file = result["output"].as<std::string>();
+        else {
+            params.input_file = result["input"].as<std::string>();
+            params.output_file = result["output"].as<std::string>();
+        }
+        if (result.count("format")) {
+            params.output_format = result["format"].as<std::string>();
+            if (!Converter::isSupportedFormat(params.output_format)) {
+                std::cerr << "Error: Unknown output format '" << params.output_format
+                        << "' (expected json, o2b, mcfunction, schem or nbt)" << std::endl;
+                return 1;
+            }
+        }
         params.target_size = result["size"].as<double>();
         params.voxel_size = result["voxel-size"].as<double>();
 
@@ -62,95 +211,88 @@ int obj2blocks_main(int argc, char* argv[]) {
         if (result.count("with-texture")) {
             params.with_texture = result["with-texture"].as<bool>();
         }
+        if (result.count("mipmaps")) {
+            params.mipmaps = result["mipmaps"].as<bool>();
+        }
+        if (result.count("tiled-textures")) {
+            params.tiled_textures = result["tiled-textures"].as<bool>();
+        }
+        params.alpha_cutoff = result["alpha-cutoff"].as<double>();
+        if (params.alpha_cutoff < 0.0 || params.alpha_cutoff > 1.0) {
+            std::cerr << "Error: --alpha-cutoff must be between 0 and 1" << std::endl;
+            return 1;
+        }
+        if (result.count("duplicate-stats")) {
+            params.count_duplicates = result["duplicate-stats"].as<bool>();
+        }
+        if (result.count("palette")) {
+            params.palette_colors = result["palette"].as<bool>();
+        }
+        if (result.count("profile")) {
+            profile_file = result["profile"].as<std::string>();
+        }
+        if (result.count("quiet")) {
+            quiet = result["quiet"].as<bool>();
+        }
     }
     catch (const cxxopts::exceptions::exception&e) {
         std::cerr << "Error parsing options: " << e.what() << "\n\n";
-        std::cout << options.help() << std::endl;
+        std::cout << options.help() << '\n';
         return 1;
     }
 
-    std::cout << "=== OBJ to Minecraft Blocks Converter ===" << std::endl;
-    std::cout << "Input: " << params.input_file << std::endl;
-    std::cout << "Output: " << params.output_file << std::endl;
-    std::cout << "Target size: " << params.target_size << std::endl;
-    std::cout << "Voxel size: " << params.voxel_size << std::endl;
-    std::cout << "Fill mode: " << (params.solid ? "solid" : "surface") << std::endl;
-    std::cout << "Optimization: " << (params.optimize ? "enabled" : "disabled") << std::endl;
-    std::cout << "Texture mapping: " << (params.with_texture ? "enabled" : "disabled") << std::endl;
-    std::cout << std::endl;
-
-    MeshProcessor processor;
-    std::cout << "Loading OBJ file..." << std::endl;
-    if (!processor.loadOBJ(params.input_file)) {
-        std::cerr << "Failed to load OBJ file." << std::endl;
-        return 1;
+    if (!batch_manifest.empty()) {
+        if (!profile_file.empty()) {
+            std::cerr << "Error: --profile reports a single conversion and cannot be used with --batch" << std::endl;
+            return 1;
+        }
+        return runBatch(params, batch_manifest, batch_jobs, quiet);
     }
 
-    processor.centerMesh();
+    NullBuffer null_buffer;
+    std::streambuf* console = quiet ? std::cout.rdbuf(&null_buffer) : nullptr;
+
+    std::cout << "=== OBJ to Minecraft Blocks Converter ===\n";
+    std::cout << "Input: " << params.input_file << '\n';
+    std::cout << "Output: " << params.output_file << " (" << Converter::resolveOutputFormat(params) << ")\n";
+    std::cout << "Target size: " << params.target_size << '\n';
+    std::cout << "Voxel size: " << params.voxel_size << '\n';
+    std::cout << "Fill mode: " << (params.solid ? "solid" : "surface") << '\n';
+    std::cout << "Optimization: " << (params.optimize ? "enabled" : "disabled") << '\n';
+    std::cout << "Texture mapping: " << (params.with_texture ? "enabled" : "disabled") << '\n';
+    if (params.alpha_cutoff > 0.0) {
+        std::cout << "Alpha cutoff: " << params.alpha_cutoff << '\n';
+    }
+    std::cout << '\n';
 
-    if (params.auto_scale) {
-        processor.autoScale(params.target_size);
-        pmp::Point min_pt, max_pt;
-        processor.getBoundingBox(min_pt, max_pt);
-        params.scale_factor = params.target_size / processor.getMaxDimension();
+    Profiler profiler;
+    profiler.setInfo("input", params.input_file);
+    profiler.setInfo("output", params.output_file);
+    profiler.setInfo("format", Converter::resolveOutputFormat(params));
+
+    Converter converter(Converter::createTextureCache(params));
+    ConversionResult conversion = converter.convert(params, profile_file.empty() ? nullptr : &profiler);
+    if (console) {
+        std::cout.rdbuf(console);
     }
-    else {
-        processor.scaleMesh(params.scale_factor);
-    }
-
-    Voxelizer voxelizer(params.voxel_size);
-    std::cout << "\nStarting voxelization..." << std::endl;
-    
-    // Check if we have material information
-    std::vector<MinecraftCommand> commands;
-    size_t total_voxels = 0;
-    
-    if (processor.hasObjLoader() && params.with_texture) {
-        // Use material-aware voxelization
-        std::set<VoxelData> voxels_with_colors = voxelizer.voxelizeWithMaterials(processor, params.solid);
-        
-        if (voxels_with_colors.empty()) {
-            std::cerr << "Error: No voxels generated from the model." << std::endl;
-            return 1;
-        }
-        
-        total_voxels = voxels_with_colors.size();
-        
-        BlockOptimizer optimizer;
-        optimizer.setOptimizationEnabled(params.optimize);
-        std::cout << "\nOptimizing block placement with colors..." << std::endl;
-        commands = optimizer.optimizeWithColors(voxels_with_colors);
-    } else {
-        // Fallback to simple voxelization
-        std::set<Vec3i> voxels = voxelizer.voxelize(processor.getMesh(), params.solid);
-        
-        if (voxels.empty()) {
-            std::cerr << "Error: No voxels generated from the model." << std::endl;
-            return 1;
-        }
-        
-        total_voxels = voxels.size();
-        
-        BlockOptimizer optimizer;
-        optimizer.setOptimizationEnabled(params.optimize);
-        std::cout << "\nOptimizing block placement..." << std::endl;
-        commands = optimizer.optimize(voxels);
+    if (!profile_file.empty() && profiler.writeToFile(profile_file) && !quiet) {
+        std::cout << "Profile written to " << profile_file << '\n';
     }
-
-    JsonExporter exporter;
-    std::cout << "\nExporting to JSON..." << std::endl;
-    if (!exporter.exportToFile(params.output_file, commands, params)) {
-        std::cerr << "Failed to export JSON file." << std::endl;
+    if (!conversion.success) {
+        std::cerr << "Error: " << conversion.error << std::endl;
         return 1;
     }
+    if (quiet) {
+        return 0;
+    }
 
-    std::cout << "\n=== Conversion Complete ===" << std::endl;
-    std::cout << "Total blocks: " << total_voxels << std::endl;
-    std::cout << "Total commands: " << commands.size() << std::endl;
+    std::cout << "\n=== Conversion Complete ===\n";
+    std::cout << "Total blocks: " << conversion.total_voxels << '\n';
+    std::cout << "Total commands: " << conversion.command_count << '\n';
 
     if (params.optimize) {
-        double reduction = 100.0 * (1.0 - (double)commands.size() / total_voxels);
-        std::cout << "Command reduction: " << reduction << "%" << std::endl;
+        double reduction = 100.0 * (1.0 - (double)conversion.command_count / conversion.total_voxels);
+        std::cout << "Command reduction: " << reduction << "%\n";
     }
 
     return 0;
@@ -159,12 +301,22 @@ int obj2blocks_main(int argc, char* argv[]) {
 
 int json2obj_main(int argc, char* argv[]) {
     std::string inputFile, outputFile;
+    bool cullHiddenFaces = false;
+    bool greedyMeshing = false;
+    bool streamOutput = false;
+    bool glbPerColor = false;
+    unsigned threads = 0;
 
     cxxopts::Options options("json2obj", "JSON to OBJ Converter");
 
     options.add_options()
-            ("i,input", "Input JSON file", cxxopts::value<std::string>())
-            ("o,output", "Output OBJ file", cxxopts::value<std::string>())
+            ("i,input", "Input JSON or binary (.o2b) command file", cxxopts::value<std::string>())
+            ("o,output", "Output OBJ file, or binary glTF when it ends in .glb", cxxopts::value<std::string>())
+            ("cull", "Only emit faces bordering empty space, with shared vertices", cxxopts::value<bool>()->default_value("false"))
+            ("greedy", "Merge coplanar same-colour faces into larger quads (implies --cull)", cxxopts::value<bool>()->default_value("false"))
+            ("stream", "Write geometry while reading commands to keep memory flat (not with --cull/--greedy)", cxxopts::value<bool>()->default_value("false"))
+            ("glb-per-color", "GLB: one flat-coloured primitive per colour instead of a texture atlas", cxxopts::value<bool>()->default_value("false"))
+            ("t,threads", "Threads used to generate and write the OBJ (0 = all cores)", cxxopts::value<unsigned>()->default_value("0"))
             ("h,help", "Show this help message");
 
     try {
@@ -183,6 +335,19 @@ int json2obj_main(int argc, char* argv[]) {
 
         inputFile = result["input"].as<std::string>();
         outputFile = result["output"].as<std::string>();
+        if (result.count("cull")) {
+            cullHiddenFaces = result["cull"].as<bool>();
+        }
+        if (result.count("greedy")) {
+            greedyMeshing = result["greedy"].as<bool>();
+        }
+        if (result.count("stream")) {
+            streamOutput = result["stream"].as<bool>();
+        }
+        if (result.count("glb-per-color")) {
+            glbPerColor = result["glb-per-color"].as<bool>();
+        }
+        threads = result["threads"].as<unsigned>();
     }
     catch (const cxxopts::exceptions::exception&e) {
         std::cerr << "Error parsing options: " << e.what() << "\n\n";
@@ -190,37 +355,195 @@ int json2obj_main(int argc, char* argv[]) {
         return 1;
     }
 
-    std::ifstream file(inputFile);
-    if (!file.is_open()) {
-        std::cerr << "Error: Cannot open input file " << inputFile << std::endl;
+    ObjGenerator generator;
+    generator.setCullHiddenFaces(cullHiddenFaces);
+    generator.setGreedyMeshing(greedyMeshing);
+    generator.setThreadCount(threads);
+    generator.setGlbPerColor(glbPerColor);
+    if (streamOutput && !generator.beginStream(outputFile)) {
+        return 1;
+    }
+
+    if (BinaryReader::isBinaryFile(inputFile)) {
+        BinaryReader reader;
+        if (!reader.readFile(inputFile)) {
+            return 1;
+        }
+        for (const auto& command : reader.getCommands()) {
+            generator.processCommand(command);
+        }
+        generator.writeToFile(outputFile);
+        return 0;
+    }
+
+    CommandStreamReader reader;
+    bool parsed = reader.readFile(inputFile, [&generator](const json& command) {
+        generator.processCommand(command);
+    }, [&generator](const std::string& key, const json& value) {
+        if (key == "palette") {
+            generator.setPalette(value);
+        }
+    });
+    if (!parsed) {
+        return 1;
+    }
+    if (!reader.hasCommandsArray()) {
+        std::cerr << "Error: JSON must contain 'commands' array" << std::endl;
         return 1;
     }
 
-    json root;
+    generator.writeToFile(outputFile);
+
+    return 0;
+}
+
+int json2png_main(int argc, char* argv[]) {
+    std::string inputFile, outputFile;
+    std::string view = "iso";
+    int size = 512;
+    unsigned threads = 0;
+
+    cxxopts::Options options("json2png", "JSON to PNG Thumbnail Renderer");
+
+    options.add_options()
+            ("i,input", "Input JSON or binary (.o2b) command file", cxxopts::value<std::string>())
+            ("o,output", "Output PNG file", cxxopts::value<std::string>())
+            ("s,size", "Thumbnail width and height in pixels", cxxopts::value<int>()->default_value("512"))
+            ("view", "Projection: iso or top", cxxopts::value<std::string>()->default_value("iso"))
+            ("t,threads", "Threads used to render (0 = all cores)", cxxopts::value<unsigned>()->default_value("0"))
+            ("h,help", "Show this help message");
+
     try {
-        file >> root;
+        auto result = options.parse(argc, argv);
+
+        if (result.count("help")) {
+            std::cout << options.help() << std::endl;
+            return 0;
+        }
+
+        if (!result.count("input") || !result.count("output")) {
+            std::cerr << "Error: Input and output files are required.\n\n";
+            std::cout << options.help() << std::endl;
+            return 1;
+        }
+
+        inputFile = result["input"].as<std::string>();
+        outputFile = result["output"].as<std::string>();
+        size = result["size"].as<int>();
+        view = result["view"].as<std::string>();
+        threads = result["threads"].as<unsigned>();
     }
-    catch (const std::exception&e) {
-        std::cerr << "Error parsing JSON: " << e.what() << std::endl;
+    catch (const cxxopts::exceptions::exception&e) {
+        std::cerr << "Error parsing options: " << e.what() << "\n\n";
+        std::cout << options.help() << std::endl;
         return 1;
     }
-    file.close();
 
-    ObjGenerator generator;
+    if (view != "iso" && view != "top") {
+        std::cerr << "Error: Unknown view '" << view << "' (expected iso or top)" << std::endl;
+        return 1;
+    }
+    if (size < 1) {
+        std::cerr << "Error: Size must be positive" << std::endl;
+        return 1;
+    }
 
-    if (root.contains("commands") && root["commands"].is_array()) {
-        for (const auto&command: root["commands"]) {
-            generator.processCommand(command);
+    ThumbnailRenderer renderer;
+    renderer.setSize(size, size);
+    renderer.setView(view == "top" ? ThumbnailView::Top : ThumbnailView::Isometric);
+    renderer.setThreadCount(threads);
+
+    if (BinaryReader::isBinaryFile(inputFile)) {
+        BinaryReader reader;
+        if (!reader.readFile(inputFile)) {
+            return 1;
+        }
+        for (const auto& command : reader.getCommands()) {
+            renderer.addCommand(command);
         }
     }
     else {
-        std::cerr << "Error: JSON must contain 'commands' array" << std::endl;
+        CommandStreamReader reader;
+        bool parsed = reader.readFile(inputFile, [&renderer](const json& command) {
+            renderer.addCommand(command);
+        }, [&renderer](const std::string& key, const json& value) {
+            if (key == "palette") {
+                renderer.setPalette(value);
+            }
+        });
+        if (!parsed) {
+            return 1;
+        }
+        if (!reader.hasCommandsArray()) {
+            std::cerr << "Error: JSON must contain 'commands' array" << std::endl;
+            return 1;
+        }
+    }
+
+    return renderer.renderToFile(outputFile) ? 0 : 1;
+}
+
+int serve_main(int argc, char* argv[]) {
+    cxxopts::Options options("serve", "Conversion server reading line-delimited JSON requests");
+
+    options.add_options()
+            ("socket", "Listen on this Unix domain socket instead of stdin/stdout", cxxopts::value<std::string>())
+            ("j,jobs", "Conversions run concurrently (0 = all cores)", cxxopts::value<unsigned>()->default_value("0"))
+            ("mesh-cache", "Parsed OBJ files kept in memory", cxxopts::value<size_t>()->default_value("32"))
+            ("texture-cache-mb", "Decoded texture memory kept (MiB, 0 = unbounded)", cxxopts::value<size_t>()->default_value("1024"))
+            ("mipmaps", "Build texture mip levels for every request", cxxopts::value<bool>()->default_value("false"))
+            ("tiled-textures", "Store textures in cache-friendly 8x8 RGBA tiles", cxxopts::value<bool>()->default_value("false"))
+            ("h,help", "Show this help message");
+
+    std::string socket_path;
+    unsigned jobs = 0;
+    size_t mesh_cache = 32;
+    size_t texture_cache_mb = 1024;
+    ConversionParams texture_params;
+    texture_params.with_texture = true;
+
+    try {
+        auto result = options.parse(argc, argv);
+
+        if (result.count("help")) {
+            std::cout << options.help() << '\n';
+            std::cout << "Requests, one JSON object per line:\n"
+                      << "  {\"id\": 1, \"input\": \"a.obj\", \"output\": \"a.json\", \"params\": {\"size\": 64}}\n"
+                      << "  {\"id\": 2, \"input\": \"a.obj\", \"return\": \"voxels\"}\n"
+                      << "  {\"op\": \"stats\"}   {\"op\": \"shutdown\"}\n"
+                      << "params: format, size, voxel_size, scale, solid, optimize, with_texture,\n"
+                      << "        alpha_cutoff, duplicate_stats, palette\n";
+            return 0;
+        }
+        if (result.count("socket")) {
+            socket_path = result["socket"].as<std::string>();
+        }
+        jobs = result["jobs"].as<unsigned>();
+        mesh_cache = result["mesh-cache"].as<size_t>();
+        texture_cache_mb = result["texture-cache-mb"].as<size_t>();
+        if (result.count("mipmaps")) {
+            texture_params.mipmaps = result["mipmaps"].as<bool>();
+        }
+        if (result.count("tiled-textures")) {
+            texture_params.tiled_textures = result["tiled-textures"].as<bool>();
+        }
+    }
+    catch (const cxxopts::exceptions::exception&e) {
+        std::cerr << "Error parsing options: " << e.what() << "\n\n";
+        std::cout << options.help() << '\n';
         return 1;
     }
 
-    generator.writeToFile(outputFile);
+    ConversionServer server(jobs, texture_params);
+    server.setMeshCacheCapacity(mesh_cache);
+    server.setTextureCacheBytes(texture_cache_mb * 1024 * 1024);
 
-    return 0;
+    // Pipeline progress from concurrent jobs would corrupt the response stream
+    NullBuffer null_buffer;
+    std::ostream responses(std::cout.rdbuf(&null_buffer));
+    int status = socket_path.empty() ? server.serveStream(std::cin, responses) : server.serveSocket(socket_path);
+    std::cout.rdbuf(responses.rdbuf());
+    return status;
 }
 
 int main(int argc, char *argv[]) {
@@ -229,6 +552,8 @@ int main(int argc, char *argv[]) {
     std::cerr << "\nModes:\n";
     std::cerr << "  obj2json    Convert OBJ file to Minecraft commands JSON\n";
     std::cerr << "  json2obj    Convert JSON commands to OBJ file\n";
+    std::cerr << "  json2png    Render JSON commands to a PNG thumbnail\n";
+    std::cerr << "  serve       Convert OBJ files on request over stdin/stdout or a socket\n";
     std::cerr << "\nUse '<mode> --help' for mode-specific options\n";
     return 1;
   }
@@ -239,11 +564,17 @@ int main(int argc, char *argv[]) {
     return obj2blocks_main(argc - 1, argv + 1);
   } else if (mode == "json2obj") {
     return json2obj_main(argc - 1, argv + 1);
+  } else if (mode == "json2png") {
+    return json2png_main(argc - 1, argv + 1);
+  } else if (mode == "serve") {
+    return serve_main(argc - 1, argv + 1);
   } else if (mode == "--help" || mode == "-h") {
     std::cout << "Usage: " << argv[0] << " <mode> [options]\n";
     std::cout << "\nModes:\n";
     std::cout << "  obj2json    Convert OBJ file to Minecraft commands JSON\n";
     std::cout << "  json2obj    Convert JSON commands to OBJ file\n";
+    std::cout << "  json2png    Render JSON commands to a PNG thumbnail\n";
+    std::cout << "  serve       Convert OBJ files on request over stdin/stdout or a socket\n";
     std::cout << "\nUse '<mode> --help' for mode-specific options\n";
     return 0;
   } else {
@@ -1,15 +1,17 @@
 #include "material_loader.h"
+#include "material_sampler.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <algorithm>
-
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+#include <cmath>
 
 namespace obj2blocks {
     
-MaterialLoader::MaterialLoader() {}
+MaterialLoader::MaterialLoader() : texture_cache_(std::make_shared<TextureCache>()) {}
+
+MaterialLoader::MaterialLoader(std::shared_ptr<TextureCache> texture_cache)
+    : texture_cache_(texture_cache ? std::move(texture_cache) : std::make_shared<TextureCache>()) {}
 
 MaterialLoader::~MaterialLoader() {}
 
@@ -39,32 +41,8 @@ bool MaterialLoader::loadMTL(const std::string& mtl_path) {
         
         if (key == "newmtl") {
             if (has_material) {
-                // Load textures for the previous material
-                if (!current_material.diffuse_texture_path.empty()) {
-                    TextureData tex_data;
-                    if (loadTexture(resolvePath(current_material.diffuse_texture_path), tex_data)) {
-                        current_material.textures[current_material.diffuse_texture_path] = tex_data;
-                    }
-                }
-                if (!current_material.emissive_texture_path.empty()) {
-                    TextureData tex_data;
-                    if (loadTexture(resolvePath(current_material.emissive_texture_path), tex_data)) {
-                        current_material.textures[current_material.emissive_texture_path] = tex_data;
-                    }
-                }
-                if (!current_material.ambient_texture_path.empty()) {
-                    TextureData tex_data;
-                    if (loadTexture(resolvePath(current_material.ambient_texture_path), tex_data)) {
-                        current_material.textures[current_material.ambient_texture_path] = tex_data;
-                    }
-                }
-                if (!current_material.specular_texture_path.empty()) {
-                    TextureData tex_data;
-                    if (loadTexture(resolvePath(current_material.specular_texture_path), tex_data)) {
-                        current_material.textures[current_material.specular_texture_path] = tex_data;
-                    }
-                }
-                materials_[current_material.name] = current_material;
+                material_dirs_[current_material.name] = base_path_;
+                materials_[current_material.name] = std::move(current_material);
             }
             current_material = Material();
             iss >> current_material.name;
@@ -76,38 +54,57 @@ bool MaterialLoader::loadMTL(const std::string& mtl_path) {
     
     // Don't forget the last material
     if (has_material) {
-        if (!current_material.diffuse_texture_path.empty()) {
-            TextureData tex_data;
-            if (loadTexture(resolvePath(current_material.diffuse_texture_path), tex_data)) {
-                current_material.textures[current_material.diffuse_texture_path] = tex_data;
-            }
-        }
-        if (!current_material.emissive_texture_path.empty()) {
-            TextureData tex_data;
-            if (loadTexture(resolvePath(current_material.emissive_texture_path), tex_data)) {
-                current_material.textures[current_material.emissive_texture_path] = tex_data;
-            }
-        }
-        if (!current_material.ambient_texture_path.empty()) {
-            TextureData tex_data;
-            if (loadTexture(resolvePath(current_material.ambient_texture_path), tex_data)) {
-                current_material.textures[current_material.ambient_texture_path] = tex_data;
-            }
-        }
-        if (!current_material.specular_texture_path.empty()) {
-            TextureData tex_data;
-            if (loadTexture(resolvePath(current_material.specular_texture_path), tex_data)) {
-                current_material.textures[current_material.specular_texture_path] = tex_data;
-            }
-        }
-        materials_[current_material.name] = current_material;
+        material_dirs_[current_material.name] = base_path_;
+        materials_[current_material.name] = std::move(current_material);
     }
     
     file.close();
-    std::cout << "Loaded " << materials_.size() << " materials from " << mtl_path << std::endl;
+
+    // Textures are decoded later by loadTextures, only for materials that are used
+    std::cout << "Loaded " << materials_.size() << " materials from " << mtl_path << '\n';
     return true;
 }
 
+size_t MaterialLoader::loadTextures(const std::unordered_set<std::string>& material_names) {
+    // Sorted so decode logs are stable
+    std::vector<std::string> names(material_names.begin(), material_names.end());
+    std::sort(names.begin(), names.end());
+
+    std::vector<std::pair<Material*, std::string>> planned;  // material, resolved path
+    std::vector<std::string> resolved;
+    for (const auto& name : names) {
+        auto it = materials_.find(name);
+        if (it == materials_.end()) continue;
+
+        // Only the channels calculateFinalColor samples
+        Material& material = it->second;
+        for (const std::string* path : {&material.diffuse_texture_path, &material.emissive_texture_path,
+                                        &material.opacity_texture_path}) {
+            if (path->empty() || material.textures.count(*path)) continue;
+            std::string full_path = resolvePath(name, *path);
+            planned.emplace_back(&material, *path);
+            resolved.push_back(full_path);
+        }
+    }
+    size_t decoded = texture_cache_->preload(resolved, threads_);
+
+    for (size_t i = 0; i < planned.size(); ++i) {
+        TextureHandle texture = texture_cache_->get(resolved[i]);
+        if (texture) {
+            planned[i].first->textures[planned[i].second] = std::move(texture);
+        }
+    }
+    return decoded;
+}
+
+size_t MaterialLoader::loadAllTextures() {
+    std::unordered_set<std::string> names;
+    for (const auto& [name, material] : materials_) {
+        names.insert(name);
+    }
+    return loadTextures(names);
+}
+
 void MaterialLoader::parseMTLLine(const std::string& line, Material& material) {
     std::istringstream iss(line);
     std::string key;
@@ -144,77 +141,56 @@ void MaterialLoader::parseMTLLine(const std::string& line, Material& material) {
     }
 }
 
-std::string MaterialLoader::resolvePath(const std::string& path) const {
-    std::filesystem::path full_path = base_path_ / path;
+std::string MaterialLoader::resolvePath(const std::string& material_name, const std::string& path) const {
+    // Relative to the MTL file that defined the material
+    auto it = material_dirs_.find(material_name);
+    std::filesystem::path full_path = (it != material_dirs_.end() ? it->second : base_path_) / path;
     return full_path.string();
 }
 
 bool MaterialLoader::loadTexture(const std::string& texture_path, TextureData& texture_data) {
-    int width, height, channels;
-    unsigned char* data = stbi_load(texture_path.c_str(), &width, &height, &channels, 0);
-    
-    if (!data) {
-        std::cerr << "Failed to load texture: " << texture_path << std::endl;
+    TextureHandle texture = texture_cache_->get(texture_path);
+    if (!texture) {
         return false;
     }
-    
-    texture_data.width = width;
-    texture_data.height = height;
-    texture_data.channels = channels;
-    texture_data.data.assign(data, data + (width * height * channels));
-    
-    stbi_image_free(data);
-    
-    std::cout << "Loaded texture: " << texture_path << " (" << width << "x" << height << ", " << channels << " channels)" << std::endl;
+    texture_data = *texture;
     return true;
 }
 
 Color4 MaterialLoader::sampleTexture(const TextureData& texture, float u, float v) const {
-    if (!texture.isValid()) {
-        return Color4();
-    }
-
-    // 确保UV坐标在[0,1]范围内（使用wrap模式）
-    u = u - std::floor(u);
-    v = v - std::floor(v);
-
-    // 处理负数情况
-    if (u < 0)
-      u += 1.0f;
-    if (v < 0)
-      v += 1.0f;
-
-    // 额外的安全检查，确保UV在[0,1]范围内
-    u = std::max(0.0f, std::min(1.0f, u));
-    v = std::max(0.0f, std::min(1.0f, v));
-
-    // 转换为像素坐标 - 使用最近邻采样保持像素风格
-    int x = static_cast<int>(u * texture.width);
-    int y = static_cast<int>((1.0f - v) * texture.height); // 翻转V坐标
+    return MaterialSampler::sampleTexture(texture, u, v);
+}
 
-    // 确保坐标在有效范围内 - 使用更严格的边界检查
-    x = std::max(0, std::min(x, texture.width - 1));
-    y = std::max(0, std::min(y, texture.height - 1));
+MaterialSampler MaterialLoader::createSampler(const Material& material) const {
+    MaterialSampler sampler(material);
+    if (!sampler.shouldBake()) {
+        return sampler;
+    }
 
-    // 计算像素索引
-    int pixel_index = (y * texture.width + x) * texture.channels;
-    
-    // 额外的安全检查 - 确保索引不会超出数据范围
-    Color4 color;
-    if (pixel_index >= 0 && texture.data.size() > 0 &&
-        pixel_index + texture.channels - 1 < static_cast<int>(texture.data.size())) {
-      color.r = texture.data[pixel_index];
-      color.g = texture.channels > 1 ? texture.data[pixel_index + 1]
-                                     : texture.data[pixel_index];
-      color.b = texture.channels > 2 ? texture.data[pixel_index + 2]
-                                     : texture.data[pixel_index];
-      color.a = texture.channels > 3 ? texture.data[pixel_index + 3] : 255;
-    } else {
-      // 安全保护：如果索引超出范围，返回白色
-      color = Color4();
+    // Keyed by the source images and the flat terms the bake folds in, so every material
+    // built from the same maps shares one baked image
+    auto handle = [&material](const std::string& path) {
+        auto it = path.empty() ? material.textures.end() : material.textures.find(path);
+        return it == material.textures.end() ? TextureHandle() : it->second;
+    };
+    std::vector<TextureHandle> sources = {handle(material.diffuse_texture_path),
+                                          handle(material.emissive_texture_path),
+                                          handle(material.opacity_texture_path)};
+    std::ostringstream key;
+    key << "final:";
+    for (const auto& source : sources) {
+        key << source.get() << ':';
+    }
+    for (float value : {material.diffuse[0], material.diffuse[1], material.diffuse[2], material.opacity,
+                        material.emissive[0], material.emissive[1], material.emissive[2]}) {
+        key << value << ':';
     }
+    key << material.emissive_texture_path.empty();
 
-    return color;
+    TextureHandle baked = texture_cache_->getDerived(key.str(), sources, [&sampler]() {
+        return sampler.bakeFinalColors();
+    });
+    return MaterialSampler(material, std::move(baked));
 }
 
 Material* MaterialLoader::getMaterial(const std::string& name) {
@@ -225,48 +201,19 @@ Material* MaterialLoader::getMaterial(const std::string& name) {
     return nullptr;
 }
 
-Color4 MaterialLoader::calculateFinalColor(const Material& material, float u, float v) const {
-    Color4 final_color;
-
-    if (material.hasDiffuseTexture()) {
-      final_color = sampleTexture(
-          material.textures.at(material.diffuse_texture_path), u, v);
-    } else {
-      final_color.r = static_cast<uint8_t>(material.diffuse[0] * 255);
-      final_color.g = static_cast<uint8_t>(material.diffuse[1] * 255);
-      final_color.b = static_cast<uint8_t>(material.diffuse[2] * 255);
-      final_color.a = static_cast<uint8_t>(material.opacity * 255);
-    }
+const Material* MaterialLoader::getMaterial(const std::string& name) const {
+    auto it = materials_.find(name);
+    return it != materials_.end() ? &it->second : nullptr;
+}
 
-    if (!material.emissive_texture_path.empty()) {
-        auto it = material.textures.find(material.emissive_texture_path);
-        if (it != material.textures.end() && it->second.isValid()) {
-            Color4 emissive = sampleTexture(it->second, u, v);
-            final_color.r = std::min(
-                255, final_color.r + static_cast<int>(emissive.r * 0.5));
-            final_color.g = std::min(
-                255, final_color.g + static_cast<int>(emissive.g * 0.5));
-            final_color.b = std::min(
-                255, final_color.b + static_cast<int>(emissive.b * 0.5));
-        }
-    } else if (material.emissive[0] > 0 || material.emissive[1] > 0 || material.emissive[2] > 0) {
-      final_color.r = std::min(
-          255, final_color.r + static_cast<int>(material.emissive[0] * 128));
-      final_color.g = std::min(
-          255, final_color.g + static_cast<int>(material.emissive[1] * 128));
-      final_color.b = std::min(
-          255, final_color.b + static_cast<int>(material.emissive[2] * 128));
-    }
+void MaterialLoader::addMaterial(Material material) {
+    std::string name = material.name;
+    materials_[name] = std::move(material);
+}
 
-    if (!material.opacity_texture_path.empty()) {
-        auto it = material.textures.find(material.opacity_texture_path);
-        if (it != material.textures.end() && it->second.isValid()) {
-            Color4 opacity = sampleTexture(it->second, u, v);
-            final_color.a = opacity.r;  // Use red channel for grayscale opacity
-        }
-    }
-    
-    return final_color;
+Color4 MaterialLoader::calculateFinalColor(const Material& material, float u, float v) const {
+    // Hot loops should build a MaterialSampler once and reuse it
+    return MaterialSampler(material).sample(u, v);
 }
 
 }  // namespace obj2blocks
\ No newline at end of file
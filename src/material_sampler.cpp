@@ -0,0 +1,205 @@
+#include "material_sampler.h"
+#include "texture_cache.h"
+#include <algorithm>
+#include <cmath>
+
+namespace obj2blocks {
+    namespace {
+        const TextureData* findTexture(const Material&material, const std::string&path) {
+            if (path.empty()) return nullptr;
+            auto it = material.textures.find(path);
+            if (it == material.textures.end() || !it->second || !it->second->isValid()) return nullptr;
+            return it->second.get();
+        }
+    }
+
+    MaterialSampler::MaterialSampler()
+        : diffuse_(nullptr), emissive_(nullptr), opacity_(nullptr), flat_color_(),
+          flat_emissive_{0, 0, 0}, has_flat_emissive_(false) {
+    }
+
+    MaterialSampler::MaterialSampler(const Material&material)
+        : diffuse_(findTexture(material, material.diffuse_texture_path)),
+          emissive_(findTexture(material, material.emissive_texture_path)),
+          opacity_(findTexture(material, material.opacity_texture_path)),
+          flat_color_(static_cast<uint8_t>(material.diffuse[0] * 255),
+                      static_cast<uint8_t>(material.diffuse[1] * 255),
+                      static_cast<uint8_t>(material.diffuse[2] * 255),
+                      static_cast<uint8_t>(material.opacity * 255)),
+          flat_emissive_{static_cast<int>(material.emissive[0] * 128),
+                         static_cast<int>(material.emissive[1] * 128),
+                         static_cast<int>(material.emissive[2] * 128)},
+          // A named but unloadable emissive map disables the flat emissive term
+          has_flat_emissive_(material.emissive_texture_path.empty() &&
+                             (material.emissive[0] > 0 || material.emissive[1] > 0 || material.emissive[2] > 0)) {
+    }
+
+    MaterialSampler::MaterialSampler(const Material&material, TextureHandle final_colors)
+        : MaterialSampler(material) {
+        final_colors_ = std::move(final_colors);
+    }
+
+    MaterialSampler::~MaterialSampler() {
+    }
+
+    Color4 MaterialSampler::combine(Color4 color, const Color4* emissive, const Color4* opacity) const {
+        if (emissive) {
+            color.r = std::min(255, color.r + static_cast<int>(emissive->r * 0.5));
+            color.g = std::min(255, color.g + static_cast<int>(emissive->g * 0.5));
+            color.b = std::min(255, color.b + static_cast<int>(emissive->b * 0.5));
+        }
+        else if (has_flat_emissive_) {
+            color.r = std::min(255, color.r + flat_emissive_[0]);
+            color.g = std::min(255, color.g + flat_emissive_[1]);
+            color.b = std::min(255, color.b + flat_emissive_[2]);
+        }
+
+        if (opacity) {
+            color.a = opacity->r;  // Grayscale opacity in red
+        }
+        return color;
+    }
+
+    bool MaterialSampler::shouldBake() const {
+        if (!emissive_ && !opacity_) {
+            return false;
+        }
+        const TextureData* maps[] = {diffuse_, emissive_, opacity_};
+        const TextureData* reference = nullptr;
+        for (const TextureData* map : maps) {
+            if (!map) continue;
+            if (!reference) {
+                reference = map;
+            }
+            else if (map->width != reference->width || map->height != reference->height ||
+                     map->mip_levels.size() != reference->mip_levels.size()) {
+                return false;
+            }
+        }
+        return static_cast<size_t>(reference->width) * reference->height <= kMaxBakeTexels;
+    }
+
+    std::shared_ptr<TextureData> MaterialSampler::bakeFinalColors() const {
+        if (!shouldBake()) {
+            return nullptr;
+        }
+        const TextureData* reference = diffuse_ ? diffuse_ : emissive_ ? emissive_ : opacity_;
+
+        auto bakeLevel = [&](int level) {
+            const TextureData&shape = reference->level(level);
+            TextureData baked;
+            baked.width = shape.width;
+            baked.height = shape.height;
+            baked.channels = 4;
+            baked.data.resize(static_cast<size_t>(baked.width) * baked.height * 4);
+            for (int y = 0; y < baked.height; ++y) {
+                for (int x = 0; x < baked.width; ++x) {
+                    Color4 base = diffuse_ ? fetchTexel(diffuse_->level(level), x, y) : flat_color_;
+                    Color4 emissive = emissive_ ? fetchTexel(emissive_->level(level), x, y) : Color4();
+                    Color4 opacity = opacity_ ? fetchTexel(opacity_->level(level), x, y) : Color4();
+                    Color4 color = combine(base, emissive_ ? &emissive : nullptr, opacity_ ? &opacity : nullptr);
+                    uint8_t* out = &baked.data[(static_cast<size_t>(y) * baked.width + x) * 4];
+                    out[0] = color.r;
+                    out[1] = color.g;
+                    out[2] = color.b;
+                    out[3] = color.a;
+                }
+            }
+            return baked;
+        };
+
+        auto baked = std::make_shared<TextureData>(bakeLevel(0));
+        for (size_t level = 1; level <= reference->mip_levels.size(); ++level) {
+            baked->mip_levels.push_back(bakeLevel(static_cast<int>(level)));
+        }
+        if (reference->layout == TextureLayout::Tiled) {
+            TextureCache::convertToTiled(*baked);
+        }
+        return baked;
+    }
+
+    int MaterialSampler::mipLevelFor(const TextureData*texture, float uv_area_per_voxel) {
+        if (!texture || texture->mip_levels.empty() || !(uv_area_per_voxel > 0.0f)) {
+            return 0;
+        }
+        // One voxel spans sqrt(texels) texels per side; level n averages 2^n per side
+        float texels = uv_area_per_voxel * static_cast<float>(texture->width) * static_cast<float>(texture->height);
+        if (texels <= 1.0f) {
+            return 0;
+        }
+        int level = static_cast<int>(std::lround(0.5f * std::log2(texels)));
+        return std::min(level, static_cast<int>(texture->mip_levels.size()));
+    }
+
+    MaterialSampler::Levels MaterialSampler::levelsFor(float uv_area_per_voxel) const {
+        Levels levels;
+        levels.diffuse = mipLevelFor(diffuse_, uv_area_per_voxel);
+        levels.emissive = mipLevelFor(emissive_, uv_area_per_voxel);
+        levels.opacity = mipLevelFor(opacity_, uv_area_per_voxel);
+        return levels;
+    }
+
+    Color4 MaterialSampler::sample(float u, float v, const Levels&levels) const {
+        if (final_colors_) {
+            // Baked maps share dimensions, so present channels agree on the level
+            return sampleTexture(final_colors_->level(std::max({levels.diffuse, levels.emissive, levels.opacity})), u, v);
+        }
+
+        Color4 color = diffuse_ ? sampleTexture(diffuse_->level(levels.diffuse), u, v) : flat_color_;
+        Color4 emissive, opacity;
+        if (emissive_) {
+            emissive = sampleTexture(emissive_->level(levels.emissive), u, v);
+        }
+        if (opacity_) {
+            opacity = sampleTexture(opacity_->level(levels.opacity), u, v);
+        }
+        return combine(color, emissive_ ? &emissive : nullptr, opacity_ ? &opacity : nullptr);
+    }
+
+    Color4 MaterialSampler::fetchTiled(const TextureData&texture, int x, int y) {
+        constexpr int tile = TextureData::kTileSize;
+        size_t tiles_x = static_cast<size_t>(texture.width + tile - 1) / tile;
+        size_t tile_index = static_cast<size_t>(y / tile) * tiles_x + x / tile;
+        const uint8_t* texel = texture.data.data() + (tile_index * tile * tile + (y % tile) * tile + x % tile) * 4;
+        return Color4(texel[0], texel[1], texel[2], texel[3]);
+    }
+
+    Color4 MaterialSampler::sampleTexture(const TextureData&texture, float u, float v) {
+        if (!texture.isValid()) {
+            return Color4();
+        }
+
+        // Wrap UVs into [0,1]
+        u = u - std::floor(u);
+        v = v - std::floor(v);
+        if (u < 0) u += 1.0f;
+        if (v < 0) v += 1.0f;
+        u = std::max(0.0f, std::min(1.0f, u));
+        v = std::max(0.0f, std::min(1.0f, v));
+
+        // Nearest texel keeps the pixel-art look
+        int x = static_cast<int>(u * texture.width);
+        int y = static_cast<int>((1.0f - v) * texture.height);
+        x = std::max(0, std::min(x, texture.width - 1));
+        y = std::max(0, std::min(y, texture.height - 1));
+
+        return fetchTexel(texture, x, y);
+    }
+
+    Color4 MaterialSampler::fetchTexel(const TextureData&texture, int x, int y) {
+        if (texture.layout == TextureLayout::Tiled) {
+            return fetchTiled(texture, x, y);
+        }
+
+        int pixel_index = (y * texture.width + x) * texture.channels;
+        Color4 color;
+        if (pixel_index >= 0 && pixel_index + texture.channels - 1 < static_cast<int>(texture.data.size())) {
+            const uint8_t* pixel = texture.data.data() + pixel_index;
+            color.r = pixel[0];
+            color.g = texture.channels > 1 ? pixel[1] : pixel[0];
+            color.b = texture.channels > 2 ? pixel[2] : pixel[0];
+            color.a = texture.channels > 3 ? pixel[3] : 255;
+        }
+        return color;
+    }
+}
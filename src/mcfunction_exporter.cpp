@@ -0,0 +1,135 @@
+#include "mcfunction_exporter.h"
+#include <iostream>
+#include <algorithm>
+
+namespace obj2blocks {
+    namespace {
+        // Defaults of the game's maxCommandChainLength gamerule and /fill volume limit
+        constexpr size_t kMaxCommandChainLength = 65536;
+        constexpr int kFillEdgeLimit = 32; // 32^3 == 32768 blocks per /fill
+
+        int chunksAlong(int min, int max) {
+            return (max - min) / kFillEdgeLimit + 1;
+        }
+    }
+
+    McfunctionExporter::McfunctionExporter() : max_commands_per_file_(kMaxCommandChainLength) {
+    }
+
+    McfunctionExporter::~McfunctionExporter() {
+    }
+
+    size_t McfunctionExporter::countLines(const std::vector<MinecraftCommand>&commands) const {
+        size_t lines = 0;
+        for (const auto&cmd: commands) {
+            if (cmd.type == CommandType::CreateBlock) {
+                lines += 1;
+            }
+            else {
+                lines += static_cast<size_t>(chunksAlong(cmd.area.min.x, cmd.area.max.x)) *
+                        chunksAlong(cmd.area.min.y, cmd.area.max.y) *
+                        chunksAlong(cmd.area.min.z, cmd.area.max.z);
+            }
+        }
+        return lines;
+    }
+
+    std::string McfunctionExporter::partFilename(const std::string&filename, size_t part) const {
+        size_t dot = filename.find_last_of('.');
+        size_t slash = filename.find_last_of("/\\");
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+            return filename + "_" + std::to_string(part);
+        }
+        return filename.substr(0, dot) + "_" + std::to_string(part) + filename.substr(dot);
+    }
+
+    bool McfunctionExporter::exportToFile(const std::string&filename,
+                                          const std::vector<MinecraftCommand>&commands) {
+        size_t limit = std::max<size_t>(1, max_commands_per_file_);
+        size_t total_lines = countLines(commands);
+        bool split = total_lines > limit;
+
+        std::ofstream file;
+        std::string buffer;
+        size_t lines_in_file = limit;
+        size_t part = 0;
+
+        auto flush = [&]() -> bool {
+            file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            buffer.clear();
+            return static_cast<bool>(file);
+        };
+
+        // Coordinates are relative to the executing position
+        auto emit = [&](const std::string&line) -> bool {
+            if (lines_in_file == limit) {
+                if (file.is_open()) {
+                    if (!flush()) return false;
+                    file.close();
+                }
+                std::string path = split ? partFilename(filename, ++part) : filename;
+                file.open(path);
+                if (!file.is_open()) {
+                    std::cerr << "Error: Could not open file for writing: " << path << std::endl;
+                    return false;
+                }
+                lines_in_file = 0;
+            }
+            buffer += line;
+            buffer += '\n';
+            lines_in_file++;
+            if (buffer.size() >= (1 << 20)) return flush();
+            return true;
+        };
+
+        for (const auto&cmd: commands) {
+            const std::string&block = palette_.blockFor(cmd.color);
+
+            if (cmd.type == CommandType::CreateBlock) {
+                const Vec3i&p = cmd.position;
+                if (!emit("setblock ~" + std::to_string(p.x) + " ~" + std::to_string(p.y) +
+                          " ~" + std::to_string(p.z) + " " + block)) {
+                    return false;
+                }
+                continue;
+            }
+
+            const Box3i&area = cmd.area;
+            for (int x = area.min.x; x <= area.max.x; x += kFillEdgeLimit) {
+                for (int y = area.min.y; y <= area.max.y; y += kFillEdgeLimit) {
+                    for (int z = area.min.z; z <= area.max.z; z += kFillEdgeLimit) {
+                        int x2 = std::min(area.max.x, x + kFillEdgeLimit - 1);
+                        int y2 = std::min(area.max.y, y + kFillEdgeLimit - 1);
+                        int z2 = std::min(area.max.z, z + kFillEdgeLimit - 1);
+                        if (!emit("fill ~" + std::to_string(x) + " ~" + std::to_string(y) +
+                                  " ~" + std::to_string(z) + " ~" + std::to_string(x2) +
+                                  " ~" + std::to_string(y2) + " ~" + std::to_string(z2) + " " + block)) {
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (total_lines == 0) {
+            file.open(filename);
+        }
+
+        if (file.is_open()) {
+            if (!flush()) {
+                std::cerr << "Error: Failed to write " << filename << std::endl;
+                return false;
+            }
+            file.close();
+        }
+
+        if (split) {
+            std::cout << "Successfully exported " << total_lines << " commands to " << part
+                    << " function files (" << partFilename(filename, 1) << " ...)\n";
+        }
+        else {
+            std::cout << "Successfully exported to: " << filename << '\n';
+        }
+        return true;
+    }
+}
@@ -0,0 +1,112 @@
+#include "mesh_cache.h"
+#include <iostream>
+
+namespace obj2blocks {
+    MeshCache::MeshCache(size_t capacity) : capacity_(capacity) {
+    }
+
+    MeshCache::~MeshCache() {
+    }
+
+    std::shared_ptr<const ObjLoader> MeshCache::get(const std::string&path,
+                                                    const std::shared_ptr<TextureCache>&textures,
+                                                    bool with_textures, unsigned decode_threads,
+                                                    size_t* textures_decoded) {
+        if (textures_decoded) {
+            *textures_decoded = 0;
+        }
+        std::error_code ec;
+        std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+        std::string file = ec ? std::filesystem::path(path).lexically_normal().string() : canonical.string();
+        std::filesystem::file_time_type modified = std::filesystem::last_write_time(file, ec);
+        uintmax_t file_size = ec ? 0 : std::filesystem::file_size(file, ec);
+        if (ec) {
+            std::cerr << "Failed to open OBJ file: " << path << std::endl;
+            return nullptr;
+        }
+        // Texture-mapped and plain conversions get separate entries, so no shared loader
+        // is ever modified after it was handed out
+        std::string key = with_textures ? file + "\n+textures" : file;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = index_.find(key);
+            if (it != index_.end()) {
+                if (it->second->modified == modified && it->second->file_size == file_size) {
+                    entries_.splice(entries_.begin(), entries_, it->second);
+                    hits_++;
+                    return it->second->loader;
+                }
+                // Changed on disk since it was cached
+                entries_.erase(it->second);
+                index_.erase(it);
+            }
+            misses_++;
+        }
+
+        // Parsed outside the lock so other files keep being served; two threads missing
+        // on the same file both parse it and the later one replaces the earlier entry
+        auto loader = std::make_shared<ObjLoader>(textures);
+        if (!loader->load(file)) {
+            return nullptr;
+        }
+        if (with_textures) {
+            loader->getMaterialLoader().setThreadCount(decode_threads);
+            size_t decoded = loader->loadTextures();
+            if (textures_decoded) {
+                *textures_decoded = decoded;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            entries_.erase(it->second);
+            index_.erase(it);
+        }
+        entries_.push_front({key, modified, file_size, loader});
+        index_[key] = entries_.begin();
+        evict(textures);
+        return loader;
+    }
+
+    void MeshCache::evict(const std::shared_ptr<TextureCache>&textures) {
+        // The texture cache keeps images that loaders still reference, so releasing older
+        // meshes is what brings it back under budget; the newest entry always stays
+        while (entries_.size() > capacity_ ||
+               (entries_.size() > 1 && textures && textures->overBudget())) {
+            index_.erase(entries_.back().key);
+            entries_.pop_back();
+            if (textures) {
+                textures->trim();
+            }
+        }
+    }
+
+    void MeshCache::setCapacity(size_t capacity) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = capacity;
+        evict(nullptr);
+    }
+
+    size_t MeshCache::size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+    size_t MeshCache::getHits() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return hits_;
+    }
+
+    size_t MeshCache::getMisses() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return misses_;
+    }
+
+    void MeshCache::clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+        index_.clear();
+    }
+}
@@ -10,14 +10,22 @@ namespace obj2blocks {
     MeshProcessor::~MeshProcessor() {
     }
 
-    bool MeshProcessor::loadOBJ(const std::string&filename) {
+    bool MeshProcessor::loadOBJ(const std::string&filename, bool load_textures) {
         // First try to load with our custom loader for material support
-        obj_loader_ = std::make_unique<ObjLoader>();
-        if (obj_loader_->load(filename)) {
+        auto obj_loader = std::make_shared<ObjLoader>(texture_cache_);
+        obj_loader->setProfiler(profiler_);
+        obj_loader->getMaterialLoader().setThreadCount(decode_threads_);
+        textures_decoded_ = 0;
+        if (obj_loader->load(filename)) {
+            if (load_textures) {
+                textures_decoded_ = obj_loader->loadTextures();
+            }
+            obj_loader_ = std::move(obj_loader);
             // Build the surface mesh from loaded data
+            Profiler::Scope scope(profiler_, "mesh_build");
             if (obj_loader_->buildSurfaceMesh(mesh_)) {
                 std::cout << "Loaded mesh with materials: " << mesh_.n_vertices() << " vertices and "
-                        << mesh_.n_faces() << " faces" << std::endl;
+                        << mesh_.n_faces() << " faces\n";
                 return true;
             }
         }
@@ -25,13 +33,14 @@ namespace obj2blocks {
         // Fallback to pmp loader if custom loader fails
         obj_loader_.reset();
         try {
+            Profiler::Scope scope(profiler_, "parse");
             pmp::read(mesh_, filename);
             if (mesh_.n_vertices() == 0) {
                 std::cerr << "Error: Loaded mesh has no vertices" << std::endl;
                 return false;
             }
             std::cout << "Loaded mesh without materials: " << mesh_.n_vertices() << " vertices and "
-                    << mesh_.n_faces() << " faces" << std::endl;
+                    << mesh_.n_faces() << " faces\n";
             return true;
         }
         catch (const std::exception&e) {
@@ -40,6 +49,17 @@ namespace obj2blocks {
         }
     }
 
+    bool MeshProcessor::loadFromLoader(std::shared_ptr<const ObjLoader> obj_loader) {
+        obj_loader_ = std::move(obj_loader);
+        Profiler::Scope scope(profiler_, "mesh_build");
+        if (!obj_loader_ || !obj_loader_->buildSurfaceMesh(mesh_)) {
+            std::cerr << "Error: In-memory mesh has no vertices or faces" << std::endl;
+            obj_loader_.reset();
+            return false;
+        }
+        return true;
+    }
+
     void MeshProcessor::scaleMesh(double scale_factor) {
         auto points = mesh_.vertex_property<pmp::Point>("v:point");
         for (auto v: mesh_.vertices()) {
@@ -52,7 +72,7 @@ namespace obj2blocks {
         if (max_dim > 0) {
             double scale_factor = target_size / max_dim;
             scaleMesh(scale_factor);
-            std::cout << "Auto-scaled mesh by factor: " << scale_factor << std::endl;
+            std::cout << "Auto-scaled mesh by factor: " << scale_factor << '\n';
         }
     }
 
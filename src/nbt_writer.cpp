@@ -0,0 +1,121 @@
+#include "nbt_writer.h"
+#include <iostream>
+#include <algorithm>
+
+namespace obj2blocks {
+    NbtWriter::NbtWriter() : file_(nullptr), failed_(false) {
+    }
+
+    NbtWriter::~NbtWriter() {
+        close();
+    }
+
+    bool NbtWriter::open(const std::string&filename) {
+        close();
+        file_ = gzopen(filename.c_str(), "wb");
+        if (!file_) {
+            std::cerr << "Error: Could not open file for writing: " << filename << std::endl;
+            return false;
+        }
+        failed_ = false;
+        buffer_.reserve(kBufferSize);
+        return true;
+    }
+
+    bool NbtWriter::close() {
+        if (!file_) return !failed_;
+        flush();
+        if (gzclose(file_) != Z_OK) failed_ = true;
+        file_ = nullptr;
+        return !failed_;
+    }
+
+    void NbtWriter::flush() {
+        if (!file_ || buffer_.empty()) return;
+        if (gzwrite(file_, buffer_.data(), static_cast<unsigned>(buffer_.size())) == 0) {
+            failed_ = true;
+        }
+        buffer_.clear();
+    }
+
+    void NbtWriter::writeHeader(TagType type, const std::string&name) {
+        put(type);
+        writeStringPayload(name);
+    }
+
+    void NbtWriter::beginCompound(const std::string&name) {
+        writeHeader(TagCompound, name);
+    }
+
+    void NbtWriter::endCompound() {
+        put(TagEnd);
+    }
+
+    void NbtWriter::writeShort(const std::string&name, int16_t value) {
+        writeHeader(TagShort, name);
+        put(static_cast<uint8_t>(static_cast<uint16_t>(value) >> 8));
+        put(static_cast<uint8_t>(value));
+    }
+
+    void NbtWriter::writeInt(const std::string&name, int32_t value) {
+        writeHeader(TagInt, name);
+        writeIntPayload(value);
+    }
+
+    void NbtWriter::writeString(const std::string&name, const std::string&value) {
+        writeHeader(TagString, name);
+        writeStringPayload(value);
+    }
+
+    void NbtWriter::writeIntArray(const std::string&name, const std::vector<int32_t>&values) {
+        writeHeader(TagIntArray, name);
+        writeIntPayload(static_cast<int32_t>(values.size()));
+        for (int32_t value: values) {
+            writeIntPayload(value);
+        }
+    }
+
+    void NbtWriter::beginByteArray(const std::string&name, int32_t length) {
+        writeHeader(TagByteArray, name);
+        writeIntPayload(length);
+    }
+
+    void NbtWriter::beginList(const std::string&name, TagType element_type, int32_t count) {
+        writeHeader(TagList, name);
+        put(count > 0 ? element_type : TagEnd);
+        writeIntPayload(count);
+    }
+
+    void NbtWriter::writeIntPayload(int32_t value) {
+        uint32_t bits = static_cast<uint32_t>(value);
+        put(static_cast<uint8_t>(bits >> 24));
+        put(static_cast<uint8_t>(bits >> 16));
+        put(static_cast<uint8_t>(bits >> 8));
+        put(static_cast<uint8_t>(bits));
+    }
+
+    void NbtWriter::writeStringPayload(const std::string&value) {
+        uint16_t length = static_cast<uint16_t>(value.size());
+        put(static_cast<uint8_t>(length >> 8));
+        put(static_cast<uint8_t>(length));
+        writeBytes(reinterpret_cast<const uint8_t*>(value.data()), length);
+    }
+
+    void NbtWriter::writeBytes(const uint8_t* data, size_t size) {
+        if (size >= kBufferSize) {
+            flush();
+            while (file_ && size > 0) {
+                unsigned chunk = static_cast<unsigned>(std::min<size_t>(size, 1u << 30));
+                if (gzwrite(file_, data, chunk) == 0) {
+                    failed_ = true;
+                    return;
+                }
+                data += chunk;
+                size -= chunk;
+            }
+            return;
+        }
+        buffer_.insert(buffer_.end(), data, data + size);
+        if (buffer_.size() >= kBufferSize) flush();
+    }
+}
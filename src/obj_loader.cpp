@@ -3,11 +3,22 @@
 #include <sstream>
 #include <iostream>
 #include <filesystem>
+#include <unordered_set>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace obj2blocks {
 
+namespace {
+// Marks a vertex without a colour in a file where other vertices have one
+const float kNoColor = std::numeric_limits<float>::quiet_NaN();
+}
+
 ObjLoader::ObjLoader() {}
 
+ObjLoader::ObjLoader(std::shared_ptr<TextureCache> texture_cache) : material_loader_(std::move(texture_cache)) {}
+
 ObjLoader::~ObjLoader() {}
 
 bool ObjLoader::load(const std::string& obj_path) {
@@ -19,27 +30,49 @@ bool ObjLoader::load(const std::string& obj_path) {
     
     std::string base_path = std::filesystem::path(obj_path).parent_path().string();
     
-    std::string line;
-    while (std::getline(file, line)) {
-        // Handle MTL lib first
-        if (line.rfind("mtllib", 0) == 0) {
-            parseMTLLib(line, base_path);
-        } else {
-            parseLine(line);
+    {
+        Profiler::Scope scope(profiler_, "parse");
+        std::string line;
+        while (std::getline(file, line)) {
+            // Handle MTL lib first
+            if (line.rfind("mtllib", 0) == 0) {
+                parseMTLLib(line, base_path);
+            } else {
+                parseLine(line);
+            }
         }
     }
     
     file.close();
+    finishVertexColors();
     
-    std::cout << "Loaded OBJ with:" << std::endl;
-    std::cout << "  Vertices: " << vertices_.size() << std::endl;
-    std::cout << "  UVs: " << uvs_.size() << std::endl;
-    std::cout << "  Normals: " << normals_.size() << std::endl;
-    std::cout << "  Faces: " << faces_.size() << std::endl;
+    std::cout << "Loaded OBJ with:\n";
+    std::cout << "  Vertices: " << vertices_.size() << '\n';
+    std::cout << "  UVs: " << uvs_.size() << '\n';
+    std::cout << "  Normals: " << normals_.size() << '\n';
+    if (!vertex_colors_.empty()) {
+        std::cout << "  Vertex colors: yes\n";
+    }
+    std::cout << "  Faces: " << faces_.size() << '\n';
     
     return !vertices_.empty() && !faces_.empty();
 }
 
+size_t ObjLoader::loadTextures() {
+    // Only materials that faces actually use; vertex-coloured meshes are voxelized
+    // from their colours and never sample a texture
+    std::unordered_set<std::string> used_materials;
+    if (vertex_colors_.empty()) {
+        for (const auto& face : faces_) {
+            if (!face.material_name.empty()) {
+                used_materials.insert(face.material_name);
+            }
+        }
+    }
+    Profiler::Scope scope(profiler_, "texture_load");
+    return material_loader_.loadTextures(used_materials);
+}
+
 void ObjLoader::parseLine(const std::string& line) {
     if (line.empty() || line[0] == '#') return;
     
@@ -65,7 +98,60 @@ void ObjLoader::parseVertex(const std::string& line) {
     std::string prefix;
     float x, y, z;
     iss >> prefix >> x >> y >> z;
-    vertices_.emplace_back(x, y, z);
+
+    // Optional vertex colour extension: v x y z r g b, scaled once the whole file is read
+    float r, g, b;
+    vertices_.push_back(pmp::Point(x, y, z));
+    if (iss >> r >> g >> b) {
+        // Vertices before the first coloured one default to white
+        raw_vertex_colors_.resize(vertices_.size() - 1, {kNoColor, kNoColor, kNoColor});
+        raw_vertex_colors_.push_back({r, g, b});
+    } else if (!raw_vertex_colors_.empty()) {
+        raw_vertex_colors_.push_back({kNoColor, kNoColor, kNoColor});
+    }
+}
+
+void ObjLoader::finishVertexColors() {
+    if (raw_vertex_colors_.empty()) {
+        return;
+    }
+
+    // One scale per file: 0-255 if any channel exceeds 1, otherwise 0-1. Deciding per
+    // vertex would read a dark 0-255 vertex such as (1, 0, 0) as full red.
+    float max_channel = 0.0f;
+    for (const auto& color : raw_vertex_colors_) {
+        max_channel = std::max({max_channel, color[0], color[1], color[2]});
+    }
+    float scale = max_channel > 1.0f ? 1.0f : 255.0f;
+    auto channel = [scale](float value) {
+        return static_cast<uint8_t>(std::clamp(std::lround(value * scale), 0L, 255L));
+    };
+
+    vertex_colors_.clear();
+    vertex_colors_.reserve(raw_vertex_colors_.size());
+    for (const auto& color : raw_vertex_colors_) {
+        if (std::isnan(color[0])) {
+            vertex_colors_.push_back(Color4());
+        } else {
+            vertex_colors_.push_back(Color4(channel(color[0]), channel(color[1]), channel(color[2])));
+        }
+    }
+    raw_vertex_colors_.clear();
+    raw_vertex_colors_.shrink_to_fit();
+}
+
+void ObjLoader::addVertex(const pmp::Point& position) {
+    vertices_.push_back(position);
+    if (!vertex_colors_.empty()) {
+        vertex_colors_.push_back(Color4());
+    }
+}
+
+void ObjLoader::addVertex(const pmp::Point& position, const Color4& color) {
+    // Vertices added before the first coloured one default to white
+    vertex_colors_.resize(vertices_.size(), Color4());
+    vertices_.push_back(position);
+    vertex_colors_.push_back(color);
 }
 
 void ObjLoader::parseUV(const std::string& line) {
@@ -132,9 +218,20 @@ void ObjLoader::parseFace(const std::string& line) {
         }
     }
     
+    addFace(face);
+}
+
+void ObjLoader::addFace(const FaceData& face) {
+    // In-memory faces may leave UV or normal indices out
+    auto indexAt = [](const std::vector<int>& indices, size_t i) {
+        return i < indices.size() ? indices[i] : -1;
+    };
+
     // Triangulate faces with more than 3 vertices
     if (face.vertex_indices.size() == 3) {
         faces_.push_back(face);
+        faces_.back().uv_indices.resize(3, -1);
+        faces_.back().normal_indices.resize(3, -1);
     } else if (face.vertex_indices.size() > 3) {
         // Fan triangulation
         for (size_t i = 1; i < face.vertex_indices.size() - 1; ++i) {
@@ -143,18 +240,18 @@ void ObjLoader::parseFace(const std::string& line) {
             
             // First vertex
             tri.vertex_indices.push_back(face.vertex_indices[0]);
-            tri.uv_indices.push_back(face.uv_indices[0]);
-            tri.normal_indices.push_back(face.normal_indices[0]);
+            tri.uv_indices.push_back(indexAt(face.uv_indices, 0));
+            tri.normal_indices.push_back(indexAt(face.normal_indices, 0));
             
             // Current vertex
             tri.vertex_indices.push_back(face.vertex_indices[i]);
-            tri.uv_indices.push_back(face.uv_indices[i]);
-            tri.normal_indices.push_back(face.normal_indices[i]);
+            tri.uv_indices.push_back(indexAt(face.uv_indices, i));
+            tri.normal_indices.push_back(indexAt(face.normal_indices, i));
             
             // Next vertex
             tri.vertex_indices.push_back(face.vertex_indices[i + 1]);
-            tri.uv_indices.push_back(face.uv_indices[i + 1]);
-            tri.normal_indices.push_back(face.normal_indices[i + 1]);
+            tri.uv_indices.push_back(indexAt(face.uv_indices, i + 1));
+            tri.normal_indices.push_back(indexAt(face.normal_indices, i + 1));
             
             faces_.push_back(tri);
         }
@@ -174,11 +271,11 @@ void ObjLoader::parseMTLLib(const std::string& line, const std::string& base_pat
     
     std::filesystem::path mtl_path = std::filesystem::path(base_path) / mtl_file;
     if (material_loader_.loadMTL(mtl_path.string())) {
-        std::cout << "Loaded MTL file: " << mtl_path.string() << std::endl;
+        std::cout << "Loaded MTL file: " << mtl_path.string() << '\n';
     }
 }
 
-bool ObjLoader::buildSurfaceMesh(pmp::SurfaceMesh& mesh) {
+bool ObjLoader::buildSurfaceMesh(pmp::SurfaceMesh& mesh) const {
     mesh.clear();
     
     // Add vertices
@@ -208,6 +305,11 @@ Material* ObjLoader::getMaterialForFace(size_t face_index) {
     return material_loader_.getMaterial(faces_[face_index].material_name);
 }
 
+const Material* ObjLoader::getMaterialForFace(size_t face_index) const {
+    if (face_index >= faces_.size()) return nullptr;
+    return material_loader_.getMaterial(faces_[face_index].material_name);
+}
+
 Vec2f ObjLoader::getUVForFaceVertex(size_t face_index, size_t vertex_index) const {
     if (face_index >= faces_.size() || vertex_index >= faces_[face_index].uv_indices.size()) {
         return Vec2f(0, 0);
@@ -0,0 +1,108 @@
+#include "parallel.h"
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace obj2blocks {
+    unsigned resolveThreadCount(unsigned requested) {
+        if (requested > 0) return requested;
+        unsigned hardware = std::thread::hardware_concurrency();
+        return hardware > 0 ? hardware : 1;
+    }
+
+    void parallelFor(size_t count, unsigned threads, const std::function<void(size_t)>&body) {
+        threads = static_cast<unsigned>(std::min<size_t>(resolveThreadCount(threads), count));
+        if (threads <= 1) {
+            for (size_t i = 0; i < count; ++i) body(i);
+            return;
+        }
+
+        std::atomic<size_t> next{0};
+        std::exception_ptr error;
+        std::mutex error_mutex;
+
+        auto worker = [&]() {
+            for (size_t i = next++; i < count; i = next++) {
+                try {
+                    body(i);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error) error = std::current_exception();
+                    next = count;
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        for (unsigned t = 1; t < threads; ++t) {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (auto&thread: workers) {
+            thread.join();
+        }
+
+        if (error) std::rethrow_exception(error);
+    }
+
+    WorkerPool::WorkerPool(unsigned threads) {
+        threads = resolveThreadCount(threads);
+        workers_.reserve(threads);
+        for (unsigned t = 0; t < threads; ++t) {
+            workers_.emplace_back([this]() { run(); });
+        }
+    }
+
+    WorkerPool::~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        task_ready_.notify_all();
+        for (auto&thread: workers_) {
+            thread.join();
+        }
+    }
+
+    void WorkerPool::submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(std::move(task));
+        }
+        task_ready_.notify_one();
+    }
+
+    void WorkerPool::wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this]() { return queue_.empty() && running_ == 0; });
+    }
+
+    void WorkerPool::run() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                task_ready_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+                if (queue_.empty()) {
+                    return;
+                }
+                task = std::move(queue_.front());
+                queue_.pop_front();
+                running_++;
+            }
+
+            task();
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_--;
+            if (queue_.empty() && running_ == 0) {
+                idle_.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,112 @@
+#include "profiler.h"
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace obj2blocks {
+    Profiler::Scope::Scope(Profiler* profiler, const char* name)
+        : profiler_(profiler), name_(name), cpu_start_(0.0) {
+        if (profiler_) {
+            wall_start_ = std::chrono::steady_clock::now();
+            cpu_start_ = processCpuSeconds();
+        }
+    }
+
+    Profiler::Scope::~Scope() {
+        if (profiler_) {
+            double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start_).count();
+            profiler_->addStage(name_, wall, processCpuSeconds() - cpu_start_);
+        }
+    }
+
+    Profiler::Profiler() : start_(std::chrono::steady_clock::now()) {
+    }
+
+    Profiler::~Profiler() {
+    }
+
+    void Profiler::addStage(const std::string&name, double wall_seconds, double cpu_seconds) {
+        uint64_t peak = peakRssBytes();
+        for (auto&stage: stages_) {
+            if (stage.name == name) {
+                stage.wall_seconds += wall_seconds;
+                stage.cpu_seconds += cpu_seconds;
+                stage.peak_rss_bytes = peak;
+                return;
+            }
+        }
+        stages_.push_back({name, wall_seconds, cpu_seconds, peak});
+    }
+
+    nlohmann::json Profiler::toJson() const {
+        nlohmann::json report;
+        for (const auto&[key, value]: info_) {
+            report[key] = value;
+        }
+
+        nlohmann::json stages = nlohmann::json::array();
+        for (const auto&stage: stages_) {
+            stages.push_back({
+                {"name", stage.name},
+                {"wall_seconds", stage.wall_seconds},
+                {"cpu_seconds", stage.cpu_seconds},
+                {"peak_rss_bytes", stage.peak_rss_bytes}
+            });
+        }
+        report["stages"] = stages;
+        report["counters"] = counters_;
+        report["total_wall_seconds"] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+        report["total_cpu_seconds"] = processCpuSeconds();
+        report["peak_rss_bytes"] = peakRssBytes();
+        return report;
+    }
+
+    bool Profiler::writeToFile(const std::string&filename) const {
+        std::ofstream file(filename);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open profile report: " << filename << std::endl;
+            return false;
+        }
+        file << toJson().dump(2) << '\n';
+        return file.good();
+    }
+
+    double Profiler::processCpuSeconds() {
+#ifdef _WIN32
+        FILETIME creation, exit, kernel, user;
+        if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) return 0.0;
+        auto ticks = [](const FILETIME&t) {
+            return (static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+        };
+        return (ticks(kernel) + ticks(user)) * 1e-7;
+#else
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+        return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+               (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+    }
+
+    uint64_t Profiler::peakRssBytes() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+        return counters.PeakWorkingSetSize;
+#else
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+        return static_cast<uint64_t>(usage.ru_maxrss); // bytes on macOS
+#else
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024; // kilobytes on Linux
+#endif
+#endif
+    }
+}
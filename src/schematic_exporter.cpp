@@ -0,0 +1,197 @@
+#include "schematic_exporter.h"
+#include "block_palette.h"
+#include "command_stats.h"
+#include "nbt_writer.h"
+#include <iostream>
+#include <algorithm>
+
+namespace obj2blocks {
+    namespace {
+        // Minecraft 1.20.1
+        constexpr int32_t kDataVersion = 3465;
+
+        // Vanilla structure blocks refuse to save or load beyond this size
+        constexpr int kStructureBlockLimit = 48;
+    }
+
+    SchematicExporter::SchematicExporter() {
+    }
+
+    SchematicExporter::~SchematicExporter() {
+    }
+
+    bool SchematicExporter::buildGrid(const std::vector<MinecraftCommand>&commands, BlockGrid&grid) {
+        if (commands.empty()) {
+            std::cerr << "Error: No commands to export" << std::endl;
+            return false;
+        }
+
+        Box3i bbox = computeCommandStats(commands, false).bounding_box;
+        grid.origin = bbox.min;
+        grid.width = bbox.max.x - bbox.min.x + 1;
+        grid.height = bbox.max.y - bbox.min.y + 1;
+        grid.length = bbox.max.z - bbox.min.z + 1;
+
+        if (grid.width > UINT16_MAX || grid.height > UINT16_MAX || grid.length > UINT16_MAX) {
+            std::cerr << "Error: Model exceeds the 65535 block schematic dimension limit" << std::endl;
+            return false;
+        }
+
+        // NBT array and list lengths are signed 32-bit
+        uint64_t cell_count = static_cast<uint64_t>(grid.width) * grid.height * grid.length;
+        if (cell_count > static_cast<uint64_t>(INT32_MAX)) {
+            std::cerr << "Error: Model bounding box holds " << cell_count << " blocks, more than the "
+                    << INT32_MAX << " an NBT file can store; reduce --size or raise --voxel-size" << std::endl;
+            return false;
+        }
+
+        grid.cells.assign(static_cast<size_t>(cell_count), 0);
+
+        // Later commands overwrite earlier ones, matching in-game placement order
+        BlockPalette palette;
+        for (const auto&cmd: commands) {
+            uint8_t block = static_cast<uint8_t>(palette.blockIndexFor(cmd.color) + 1);
+            Box3i area = cmd.type == CommandType::CreateBlock ? Box3i(cmd.position, cmd.position) : cmd.area;
+            for (int y = area.min.y; y <= area.max.y; ++y) {
+                for (int z = area.min.z; z <= area.max.z; ++z) {
+                    size_t row = grid.index(area.min.x - grid.origin.x, y - grid.origin.y, z - grid.origin.z);
+                    std::fill_n(grid.cells.begin() + row, area.max.x - area.min.x + 1, block);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool SchematicExporter::exportSchematic(const std::string&filename,
+                                            const std::vector<MinecraftCommand>&commands) {
+        BlockGrid grid;
+        if (!buildGrid(commands, grid)) return false;
+
+        // Compact palette of the blocks actually present, air first
+        const auto&block_names = BlockPalette::getBlockNames();
+        std::vector<uint8_t> remap(block_names.size() + 1, 0);
+        std::vector<bool> used(block_names.size() + 1, false);
+        for (uint8_t cell: grid.cells) used[cell] = true;
+
+        std::vector<std::string> palette = {"minecraft:air"};
+        for (size_t i = 1; i < used.size(); ++i) {
+            if (used[i]) {
+                remap[i] = static_cast<uint8_t>(palette.size());
+                palette.push_back(block_names[i - 1]);
+            }
+        }
+
+        NbtWriter writer;
+        if (!writer.open(filename)) return false;
+
+        writer.beginCompound("Schematic");
+        writer.writeInt("Version", 2);
+        writer.writeInt("DataVersion", kDataVersion);
+        writer.writeShort("Width", static_cast<int16_t>(grid.width));
+        writer.writeShort("Height", static_cast<int16_t>(grid.height));
+        writer.writeShort("Length", static_cast<int16_t>(grid.length));
+        writer.writeIntArray("Offset", {grid.origin.x, grid.origin.y, grid.origin.z});
+        writer.writeInt("PaletteMax", static_cast<int32_t>(palette.size()));
+
+        writer.beginCompound("Palette");
+        for (size_t i = 0; i < palette.size(); ++i) {
+            writer.writeInt(palette[i], static_cast<int32_t>(i));
+        }
+        writer.endCompound();
+
+        // BlockData is varint-encoded in x + z * Width + y * Width * Length order.
+        // The palette never exceeds 127 entries, so each varint is a single byte
+        // and the grid rows can be streamed out directly after remapping.
+        writer.beginByteArray("BlockData", static_cast<int32_t>(grid.cells.size()));
+        std::vector<uint8_t> row(grid.width);
+        for (size_t offset = 0; offset < grid.cells.size(); offset += grid.width) {
+            for (int x = 0; x < grid.width; ++x) {
+                row[x] = remap[grid.cells[offset + x]];
+            }
+            writer.writeBytes(row.data(), row.size());
+        }
+
+        writer.endCompound();
+
+        if (!writer.close()) {
+            std::cerr << "Error: Failed to write schematic: " << filename << std::endl;
+            return false;
+        }
+
+        std::cout << "Successfully exported schematic to: " << filename << " ("
+                << grid.width << "x" << grid.height << "x" << grid.length << ", "
+                << palette.size() << " palette entries)\n";
+        return true;
+    }
+
+    bool SchematicExporter::exportStructure(const std::string&filename,
+                                            const std::vector<MinecraftCommand>&commands) {
+        BlockGrid grid;
+        if (!buildGrid(commands, grid)) return false;
+
+        if (grid.width > kStructureBlockLimit || grid.height > kStructureBlockLimit ||
+            grid.length > kStructureBlockLimit) {
+            std::cout << "Warning: Structure exceeds " << kStructureBlockLimit
+                    << " blocks per axis; load it with /place template rather than a structure block\n";
+        }
+
+        const auto&block_names = BlockPalette::getBlockNames();
+        std::vector<int32_t> remap(block_names.size() + 1, -1);
+        std::vector<std::string> palette;
+        int32_t block_count = 0;
+        for (uint8_t cell: grid.cells) {
+            if (cell == 0) continue;
+            block_count++;
+            if (remap[cell] < 0) {
+                remap[cell] = static_cast<int32_t>(palette.size());
+                palette.push_back(block_names[cell - 1]);
+            }
+        }
+
+        NbtWriter writer;
+        if (!writer.open(filename)) return false;
+
+        writer.beginCompound("");
+        writer.writeInt("DataVersion", kDataVersion);
+
+        writer.beginList("size", NbtWriter::TagInt, 3);
+        writer.writeIntPayload(grid.width);
+        writer.writeIntPayload(grid.height);
+        writer.writeIntPayload(grid.length);
+
+        writer.beginList("palette", NbtWriter::TagCompound, static_cast<int32_t>(palette.size()));
+        for (const auto&name: palette) {
+            writer.writeString("Name", name);
+            writer.endCompound();
+        }
+
+        writer.beginList("blocks", NbtWriter::TagCompound, block_count);
+        for (int y = 0; y < grid.height; ++y) {
+            for (int z = 0; z < grid.length; ++z) {
+                for (int x = 0; x < grid.width; ++x) {
+                    uint8_t cell = grid.cells[grid.index(x, y, z)];
+                    if (cell == 0) continue;
+                    writer.beginList("pos", NbtWriter::TagInt, 3);
+                    writer.writeIntPayload(x);
+                    writer.writeIntPayload(y);
+                    writer.writeIntPayload(z);
+                    writer.writeInt("state", remap[cell]);
+                    writer.endCompound();
+                }
+            }
+        }
+
+        writer.beginList("entities", NbtWriter::TagCompound, 0);
+        writer.endCompound();
+
+        if (!writer.close()) {
+            std::cerr << "Error: Failed to write structure: " << filename << std::endl;
+            return false;
+        }
+
+        std::cout << "Successfully exported structure to: " << filename << " ("
+                << block_count << " blocks, " << palette.size() << " palette entries)\n";
+        return true;
+    }
+}
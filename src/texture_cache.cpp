@@ -0,0 +1,372 @@
+#include "texture_cache.h"
+#include "parallel.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+namespace obj2blocks {
+    TextureCache::TextureCache() {
+    }
+
+    TextureCache::~TextureCache() {
+    }
+
+    std::string TextureCache::cacheKey(const std::string&path) {
+        std::error_code ec;
+        std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+        return ec ? std::filesystem::path(path).lexically_normal().string() : canonical.string();
+    }
+
+    std::string TextureCache::memoryKey(const std::vector<uint8_t>&bytes) {
+        // FNV-1a; the size is part of the key as well
+        uint64_t hash = 14695981039346656037ull;
+        for (uint8_t byte : bytes) {
+            hash = (hash ^ byte) * 1099511628211ull;
+        }
+        return "memory:" + std::to_string(bytes.size()) + ":" + std::to_string(hash);
+    }
+
+    bool TextureCache::decode(const std::string&path, TextureData&texture) {
+        int width, height, channels;
+        unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 0);
+        if (!data) {
+            return false;
+        }
+
+        texture.width = width;
+        texture.height = height;
+        texture.channels = channels;
+        texture.data.assign(data, data + static_cast<size_t>(width) * height * channels);
+        stbi_image_free(data);
+        return true;
+    }
+
+    bool TextureCache::decodeMemory(const std::vector<uint8_t>&bytes, TextureData&texture) {
+        int width, height, channels;
+        unsigned char* data = stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()),
+                                                    &width, &height, &channels, 0);
+        if (!data) {
+            return false;
+        }
+
+        texture.width = width;
+        texture.height = height;
+        texture.channels = channels;
+        texture.data.assign(data, data + static_cast<size_t>(width) * height * channels);
+        stbi_image_free(data);
+        return true;
+    }
+
+    void TextureCache::prepare(TextureData&texture) const {
+        if (generate_mipmaps_) {
+            buildMipmaps(texture);
+        }
+        if (tiled_layout_) {
+            convertToTiled(texture);
+        }
+    }
+
+    void TextureCache::buildMipmaps(TextureData&texture) {
+        texture.mip_levels.clear();
+        const TextureData* source = &texture;
+        while (source->width > 1 || source->height > 1) {
+            TextureData next;
+            next.width = std::max(1, source->width / 2);
+            next.height = std::max(1, source->height / 2);
+            next.channels = source->channels;
+            next.data.resize(static_cast<size_t>(next.width) * next.height * next.channels);
+
+            // Average each 2x2 block; odd edges reuse the last row/column
+            int channels = source->channels;
+            for (int y = 0; y < next.height; ++y) {
+                int y0 = std::min(2 * y, source->height - 1);
+                int y1 = std::min(2 * y + 1, source->height - 1);
+                for (int x = 0; x < next.width; ++x) {
+                    int x0 = std::min(2 * x, source->width - 1);
+                    int x1 = std::min(2 * x + 1, source->width - 1);
+                    const uint8_t* p00 = &source->data[(static_cast<size_t>(y0) * source->width + x0) * channels];
+                    const uint8_t* p01 = &source->data[(static_cast<size_t>(y0) * source->width + x1) * channels];
+                    const uint8_t* p10 = &source->data[(static_cast<size_t>(y1) * source->width + x0) * channels];
+                    const uint8_t* p11 = &source->data[(static_cast<size_t>(y1) * source->width + x1) * channels];
+                    uint8_t* out = &next.data[(static_cast<size_t>(y) * next.width + x) * channels];
+                    for (int c = 0; c < channels; ++c) {
+                        out[c] = static_cast<uint8_t>((p00[c] + p01[c] + p10[c] + p11[c] + 2) / 4);
+                    }
+                }
+            }
+
+            texture.mip_levels.push_back(std::move(next));
+            source = &texture.mip_levels.back();
+        }
+    }
+
+    void TextureCache::convertToTiled(TextureData&texture) {
+        for (auto&level : texture.mip_levels) {
+            convertToTiled(level);
+        }
+        if (texture.layout == TextureLayout::Tiled || !texture.isValid()) {
+            return;
+        }
+
+        constexpr int tile = TextureData::kTileSize;
+        int tiles_x = (texture.width + tile - 1) / tile;
+        int tiles_y = (texture.height + tile - 1) / tile;
+        int channels = texture.channels;
+        std::vector<uint8_t> tiled(static_cast<size_t>(tiles_x) * tiles_y * tile * tile * 4, 0);
+
+        for (int y = 0; y < texture.height; ++y) {
+            for (int x = 0; x < texture.width; ++x) {
+                const uint8_t* in = &texture.data[(static_cast<size_t>(y) * texture.width + x) * channels];
+                size_t tile_index = static_cast<size_t>(y / tile) * tiles_x + x / tile;
+                uint8_t* out = &tiled[(tile_index * tile * tile + (y % tile) * tile + x % tile) * 4];
+                // Same channel expansion as the row-major sampler
+                out[0] = in[0];
+                out[1] = channels > 1 ? in[1] : in[0];
+                out[2] = channels > 2 ? in[2] : in[0];
+                out[3] = channels > 3 ? in[3] : 255;
+            }
+        }
+
+        texture.data = std::move(tiled);
+        texture.channels = 4;
+        texture.layout = TextureLayout::Tiled;
+    }
+
+    TextureCache::Claim::~Claim() {
+        if (keys.empty()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(cache.mutex_);
+        for (const auto&key : keys) {
+            cache.in_flight_.erase(key);
+        }
+        cache.decoded_.notify_all();
+    }
+
+    const TextureCache::Entry* TextureCache::waitForDecode(std::unique_lock<std::mutex>&lock,
+                                                           const std::string&key) {
+        decoded_.wait(lock, [&] { return in_flight_.count(key) == 0; });
+        return touch(key);
+    }
+
+    TextureHandle TextureCache::get(const std::string&path) {
+        std::string key = cacheKey(path);
+        Claim claim{*this, {}};
+        {
+            // A file another thread is decoding is waited for, not decoded again
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (const Entry* entry = waitForDecode(lock, key)) {
+                return entry->texture;
+            }
+            in_flight_.insert(key);
+            claim.keys.push_back(key);
+        }
+
+        auto texture = std::make_shared<TextureData>();
+        if (decode(key, *texture)) {
+            prepare(*texture);
+            std::cout << "Loaded texture: " << key << " (" << texture->width << "x"
+                      << texture->height << ", " << texture->channels << " channels)\n";
+        }
+        else {
+            std::cerr << "Failed to load texture: " << key << std::endl;
+            texture.reset();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        return publish(key, std::move(texture));
+    }
+
+    size_t TextureCache::preload(const std::vector<std::string>&paths, unsigned threads) {
+        // Unique keys that are neither cached nor being decoded elsewhere, in first-seen
+        // order; get() waits for the ones another thread is decoding
+        Claim claim{*this, {}};
+        const std::vector<std::string>&pending = claim.keys;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto&path : paths) {
+                std::string key = cacheKey(path);
+                if (touch(key) || !in_flight_.insert(key).second) continue;
+                claim.keys.push_back(key);
+            }
+        }
+        if (pending.empty()) {
+            return 0;
+        }
+
+        std::vector<std::shared_ptr<TextureData>> decoded(pending.size());
+        parallelFor(pending.size(), threads, [&](size_t i) {
+            auto texture = std::make_shared<TextureData>();
+            if (decode(pending[i], *texture)) {
+                prepare(*texture);
+                decoded[i] = std::move(texture);
+            }
+        });
+
+        // Report and publish in a fixed order so logs do not interleave
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t added = 0;
+        for (size_t i = 0; i < pending.size(); ++i) {
+            if (decoded[i]) {
+                std::cout << "Loaded texture: " << pending[i] << " (" << decoded[i]->width << "x"
+                          << decoded[i]->height << ", " << decoded[i]->channels << " channels)\n";
+            }
+            else {
+                std::cerr << "Failed to load texture: " << pending[i] << std::endl;
+            }
+            TextureHandle texture = decoded[i];
+            // Another thread may have published the same file first
+            if (publish(pending[i], std::move(decoded[i])) == texture && texture) {
+                added++;
+            }
+        }
+        return added;
+    }
+
+    TextureHandle TextureCache::getFromMemory(const std::vector<uint8_t>&bytes, bool* decoded) {
+        std::string key = memoryKey(bytes);
+        Claim claim{*this, {}};
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (const Entry* entry = waitForDecode(lock, key)) {
+                if (decoded) {
+                    *decoded = false;
+                }
+                return entry->texture;
+            }
+            in_flight_.insert(key);
+            claim.keys.push_back(key);
+        }
+
+        // Decoded outside the lock while other callers for the same bytes wait
+        std::shared_ptr<TextureData> texture = std::make_shared<TextureData>();
+        if (decodeMemory(bytes, *texture)) {
+            prepare(*texture);
+        }
+        else {
+            std::cerr << "Failed to decode in-memory texture (" << bytes.size() << " bytes)" << std::endl;
+            texture.reset();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        TextureHandle ours = texture;
+        TextureHandle result = publish(key, std::move(texture));
+        if (decoded) {
+            *decoded = ours && result == ours;
+        }
+        return result;
+    }
+
+    TextureHandle TextureCache::getDerived(const std::string&key, const std::vector<TextureHandle>&sources,
+                                           const std::function<std::shared_ptr<TextureData>()>&build) {
+        // Weak references make a key reused by new images at old addresses a miss
+        auto matches = [&sources](const Entry&entry) {
+            if (entry.sources.size() != sources.size()) return false;
+            for (size_t i = 0; i < sources.size(); ++i) {
+                if (entry.sources[i].lock() != sources[i]) return false;
+            }
+            return true;
+        };
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (const Entry* entry = touch(key)) {
+                if (matches(*entry)) {
+                    return entry->texture;
+                }
+                total_bytes_ -= entry->bytes;
+                textures_.erase(key);
+            }
+        }
+
+        std::shared_ptr<TextureData> texture = build();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        TextureHandle result = publish(key, std::move(texture));
+        // The key holds the source addresses, so a racing build used the same sources
+        textures_[key].sources.assign(sources.begin(), sources.end());
+        return result;
+    }
+
+    const TextureCache::Entry* TextureCache::touch(const std::string&key) {
+        auto it = textures_.find(key);
+        if (it == textures_.end()) {
+            return nullptr;
+        }
+        it->second.last_used = ++clock_;
+        return &it->second;
+    }
+
+    TextureHandle TextureCache::publish(const std::string&key, std::shared_ptr<TextureData> texture) {
+        auto [it, inserted] = textures_.try_emplace(key);
+        if (inserted) {
+            it->second.texture = std::move(texture);
+            it->second.bytes = it->second.texture ? textureBytes(*it->second.texture) : 0;
+            total_bytes_ += it->second.bytes;
+        }
+        it->second.last_used = ++clock_;
+        TextureHandle result = it->second.texture;
+        evict(key);
+        return result;
+    }
+
+    void TextureCache::evict(const std::string&keep) {
+        // Least recently used first; a linear scan is fine for the few hundred images a cache holds
+        while (capacity_bytes_ > 0 && total_bytes_ > capacity_bytes_) {
+            auto victim = textures_.end();
+            for (auto it = textures_.begin(); it != textures_.end(); ++it) {
+                if (it->first == keep || it->second.texture.use_count() > 1) continue;
+                if (victim == textures_.end() || it->second.last_used < victim->second.last_used) {
+                    victim = it;
+                }
+            }
+            if (victim == textures_.end()) {
+                return;
+            }
+            total_bytes_ -= victim->second.bytes;
+            textures_.erase(victim);
+        }
+    }
+
+    bool TextureCache::overBudget() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return capacity_bytes_ > 0 && total_bytes_ > capacity_bytes_;
+    }
+
+    void TextureCache::trim() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        evict("");
+    }
+
+    size_t TextureCache::textureBytes(const TextureData&texture) {
+        size_t bytes = texture.data.size();
+        for (const auto&level : texture.mip_levels) {
+            bytes += level.data.size();
+        }
+        return bytes;
+    }
+
+    void TextureCache::setCapacityBytes(size_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_bytes_ = bytes;
+        evict("");
+    }
+
+    size_t TextureCache::memoryBytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return total_bytes_;
+    }
+
+    size_t TextureCache::size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return textures_.size();
+    }
+
+    void TextureCache::clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        textures_.clear();
+        total_bytes_ = 0;
+    }
+}
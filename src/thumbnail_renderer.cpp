@@ -0,0 +1,284 @@
+#include "thumbnail_renderer.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <stb_image_write.h>
+
+namespace obj2blocks {
+    namespace {
+        constexpr int kTileSize = 64;
+        constexpr int kMargin = 4;
+
+        struct ScreenPoint {
+            float x, y, depth;
+        };
+
+        // One visible box face in pixel space
+        struct ScreenQuad {
+            ScreenPoint corners[4];
+            uint8_t r, g, b;
+        };
+
+        struct FaceDesc {
+            int axis;
+            float shade;
+        };
+
+        // Faces that can point at the camera, with simple directional shading
+        const FaceDesc kIsometricFaces[] = {{1, 1.0f}, {0, 0.8f}, {2, 0.65f}};
+        const FaceDesc kTopFaces[] = {{1, 1.0f}};
+
+        // Orthographic projections; larger depth is closer to the camera
+        ScreenPoint project(ThumbnailView view, float x, float y, float z) {
+            if (view == ThumbnailView::Top) {
+                return {x, z, y};
+            }
+            constexpr float cos30 = 0.8660254f;
+            return {(x - z) * cos30, (x + z) * 0.5f - y, x + y + z};
+        }
+
+        Color4 parseColor(const nlohmann::json&col) {
+            Color4 color;
+            if (col.is_array() && col.size() >= 3) {
+                color.r = col[0].get<uint8_t>();
+                color.g = col[1].get<uint8_t>();
+                color.b = col[2].get<uint8_t>();
+                if (col.size() >= 4) {
+                    color.a = col[3].get<uint8_t>();
+                }
+            }
+            return color;
+        }
+
+        float edge(const ScreenPoint&a, const ScreenPoint&b, float px, float py) {
+            return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+        }
+
+        void rasterizeTriangle(ScreenPoint v0, ScreenPoint v1, ScreenPoint v2, const ScreenQuad&quad,
+                               int tileX0, int tileY0, int tileX1, int tileY1, int width,
+                               std::vector<float>&depth, std::vector<uint8_t>&pixels) {
+            float area = edge(v0, v1, v2.x, v2.y);
+            if (area == 0.0f) return;
+            if (area < 0.0f) {
+                std::swap(v1, v2);
+                area = -area;
+            }
+
+            int x0 = std::max(tileX0, static_cast<int>(std::floor(std::min({v0.x, v1.x, v2.x}))));
+            int y0 = std::max(tileY0, static_cast<int>(std::floor(std::min({v0.y, v1.y, v2.y}))));
+            int x1 = std::min(tileX1 - 1, static_cast<int>(std::ceil(std::max({v0.x, v1.x, v2.x}))));
+            int y1 = std::min(tileY1 - 1, static_cast<int>(std::ceil(std::max({v0.y, v1.y, v2.y}))));
+
+            for (int y = y0; y <= y1; ++y) {
+                float py = y + 0.5f;
+                for (int x = x0; x <= x1; ++x) {
+                    float px = x + 0.5f;
+                    // Inclusive edges so faces sharing an edge leave no cracks
+                    float w0 = edge(v1, v2, px, py);
+                    float w1 = edge(v2, v0, px, py);
+                    float w2 = edge(v0, v1, px, py);
+                    if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+
+                    float z = (w0 * v0.depth + w1 * v1.depth + w2 * v2.depth) / area;
+                    size_t idx = static_cast<size_t>(y) * width + x;
+                    if (z <= depth[idx]) continue;
+
+                    depth[idx] = z;
+                    pixels[idx * 4] = quad.r;
+                    pixels[idx * 4 + 1] = quad.g;
+                    pixels[idx * 4 + 2] = quad.b;
+                    pixels[idx * 4 + 3] = 255;
+                }
+            }
+        }
+    }
+
+    ThumbnailRenderer::ThumbnailRenderer()
+        : width_(512), height_(512), view_(ThumbnailView::Isometric), threads_(0) {
+    }
+
+    ThumbnailRenderer::~ThumbnailRenderer() {
+    }
+
+    void ThumbnailRenderer::setSize(int width, int height) {
+        width_ = std::max(1, width);
+        height_ = std::max(1, height);
+    }
+
+    void ThumbnailRenderer::setPalette(const nlohmann::json&palette) {
+        palette_.clear();
+        for (const auto&col : palette) {
+            palette_.push_back(parseColor(col));
+        }
+    }
+
+    void ThumbnailRenderer::addCommand(const nlohmann::json&command) {
+        Color4 color;
+        if (command.contains("color")) {
+            const auto&col = command["color"];
+            if (col.is_number_integer()) {
+                int index = col.get<int>();
+                if (index >= 0 && index < static_cast<int>(palette_.size())) {
+                    color = palette_[index];
+                }
+            }
+            else {
+                color = parseColor(col);
+            }
+        }
+
+        const std::string type = command.value("type", "");
+        if (type == "createblock") {
+            const auto&pos = command["position"];
+            addCommand(MinecraftCommand(Vec3i(pos[0], pos[1], pos[2]), color));
+        }
+        else if (type == "fillarea") {
+            const auto&c1 = command["corner1"];
+            const auto&c2 = command["corner2"];
+            Vec3i a(c1[0], c1[1], c1[2]);
+            Vec3i b(c2[0], c2[1], c2[2]);
+            Box3i area(Vec3i(std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z)),
+                       Vec3i(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z)));
+            addCommand(MinecraftCommand(area, color));
+        }
+    }
+
+    void ThumbnailRenderer::addCommand(const MinecraftCommand&command) {
+        Box3i cells = command.type == CommandType::CreateBlock
+                          ? Box3i(command.position, command.position)
+                          : command.area;
+        Box box;
+        box.min[0] = static_cast<float>(cells.min.x);
+        box.min[1] = static_cast<float>(cells.min.y);
+        box.min[2] = static_cast<float>(cells.min.z);
+        box.max[0] = static_cast<float>(cells.max.x + 1);
+        box.max[1] = static_cast<float>(cells.max.y + 1);
+        box.max[2] = static_cast<float>(cells.max.z + 1);
+        box.color = command.color;
+        boxes_.push_back(box);
+    }
+
+    std::vector<uint8_t> ThumbnailRenderer::renderPixels() const {
+        std::vector<uint8_t> pixels(static_cast<size_t>(width_) * height_ * 4, 0);
+        if (boxes_.empty()) {
+            return pixels;
+        }
+
+        // Fit the projected bounding box into the image
+        float lo[3], hi[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            lo[axis] = std::numeric_limits<float>::max();
+            hi[axis] = std::numeric_limits<float>::lowest();
+        }
+        for (const Box&box : boxes_) {
+            for (int axis = 0; axis < 3; ++axis) {
+                lo[axis] = std::min(lo[axis], box.min[axis]);
+                hi[axis] = std::max(hi[axis], box.max[axis]);
+            }
+        }
+        float minX = std::numeric_limits<float>::max(), maxX = std::numeric_limits<float>::lowest();
+        float minY = minX, maxY = maxX;
+        for (int corner = 0; corner < 8; ++corner) {
+            ScreenPoint p = project(view_, corner & 1 ? hi[0] : lo[0], corner & 2 ? hi[1] : lo[1],
+                                    corner & 4 ? hi[2] : lo[2]);
+            minX = std::min(minX, p.x);
+            maxX = std::max(maxX, p.x);
+            minY = std::min(minY, p.y);
+            maxY = std::max(maxY, p.y);
+        }
+        float usableW = static_cast<float>(std::max(1, width_ - 2 * kMargin));
+        float usableH = static_cast<float>(std::max(1, height_ - 2 * kMargin));
+        float scale = std::min(usableW / std::max(maxX - minX, 1e-6f), usableH / std::max(maxY - minY, 1e-6f));
+        float offsetX = (width_ - (maxX - minX) * scale) * 0.5f - minX * scale;
+        float offsetY = (height_ - (maxY - minY) * scale) * 0.5f - minY * scale;
+
+        // Project every visible face into a fixed slot so the work splits cleanly
+        const FaceDesc* faces = view_ == ThumbnailView::Top ? kTopFaces : kIsometricFaces;
+        size_t facesPerBox = view_ == ThumbnailView::Top ? std::size(kTopFaces) : std::size(kIsometricFaces);
+        std::vector<ScreenQuad> quads(boxes_.size() * facesPerBox);
+
+        constexpr size_t projectChunk = 1 << 14;
+        parallelFor((boxes_.size() + projectChunk - 1) / projectChunk, threads_, [&](size_t chunk) {
+            size_t end = std::min(boxes_.size(), (chunk + 1) * projectChunk);
+            for (size_t i = chunk * projectChunk; i < end; ++i) {
+                const Box&box = boxes_[i];
+                for (size_t f = 0; f < facesPerBox; ++f) {
+                    int axis = faces[f].axis;
+                    int u = (axis + 1) % 3;
+                    int v = (axis + 2) % 3;
+                    ScreenQuad&quad = quads[i * facesPerBox + f];
+                    const float uv[4][2] = {
+                        {box.min[u], box.min[v]}, {box.max[u], box.min[v]},
+                        {box.max[u], box.max[v]}, {box.min[u], box.max[v]}
+                    };
+                    for (int c = 0; c < 4; ++c) {
+                        float p[3];
+                        p[axis] = box.max[axis];
+                        p[u] = uv[c][0];
+                        p[v] = uv[c][1];
+                        ScreenPoint s = project(view_, p[0], p[1], p[2]);
+                        quad.corners[c] = {s.x * scale + offsetX, s.y * scale + offsetY, s.depth};
+                    }
+                    quad.r = static_cast<uint8_t>(box.color.r * faces[f].shade);
+                    quad.g = static_cast<uint8_t>(box.color.g * faces[f].shade);
+                    quad.b = static_cast<uint8_t>(box.color.b * faces[f].shade);
+                }
+            }
+        });
+
+        // Bin quads by the tiles their screen bounds touch; bins keep command order
+        int tilesX = (width_ + kTileSize - 1) / kTileSize;
+        int tilesY = (height_ + kTileSize - 1) / kTileSize;
+        std::vector<std::vector<uint32_t>> bins(static_cast<size_t>(tilesX) * tilesY);
+        for (size_t q = 0; q < quads.size(); ++q) {
+            const ScreenQuad&quad = quads[q];
+            float qx0 = quad.corners[0].x, qx1 = qx0, qy0 = quad.corners[0].y, qy1 = qy0;
+            for (int c = 1; c < 4; ++c) {
+                qx0 = std::min(qx0, quad.corners[c].x);
+                qx1 = std::max(qx1, quad.corners[c].x);
+                qy0 = std::min(qy0, quad.corners[c].y);
+                qy1 = std::max(qy1, quad.corners[c].y);
+            }
+            int tx0 = std::clamp(static_cast<int>(std::floor(qx0)) / kTileSize, 0, tilesX - 1);
+            int tx1 = std::clamp(static_cast<int>(std::ceil(qx1)) / kTileSize, 0, tilesX - 1);
+            int ty0 = std::clamp(static_cast<int>(std::floor(qy0)) / kTileSize, 0, tilesY - 1);
+            int ty1 = std::clamp(static_cast<int>(std::ceil(qy1)) / kTileSize, 0, tilesY - 1);
+            for (int ty = ty0; ty <= ty1; ++ty) {
+                for (int tx = tx0; tx <= tx1; ++tx) {
+                    bins[static_cast<size_t>(ty) * tilesX + tx].push_back(static_cast<uint32_t>(q));
+                }
+            }
+        }
+
+        // Tiles own disjoint pixels, so they rasterize independently and deterministically
+        std::vector<float> depth(static_cast<size_t>(width_) * height_, std::numeric_limits<float>::lowest());
+        parallelFor(bins.size(), threads_, [&](size_t tile) {
+            int tileX0 = static_cast<int>(tile % tilesX) * kTileSize;
+            int tileY0 = static_cast<int>(tile / tilesX) * kTileSize;
+            int tileX1 = std::min(width_, tileX0 + kTileSize);
+            int tileY1 = std::min(height_, tileY0 + kTileSize);
+            for (uint32_t q : bins[tile]) {
+                const ScreenQuad&quad = quads[q];
+                rasterizeTriangle(quad.corners[0], quad.corners[1], quad.corners[2], quad,
+                                  tileX0, tileY0, tileX1, tileY1, width_, depth, pixels);
+                rasterizeTriangle(quad.corners[0], quad.corners[2], quad.corners[3], quad,
+                                  tileX0, tileY0, tileX1, tileY1, width_, depth, pixels);
+            }
+        });
+
+        return pixels;
+    }
+
+    bool ThumbnailRenderer::renderToFile(const std::string&filename) const {
+        std::vector<uint8_t> pixels = renderPixels();
+        if (!stbi_write_png(filename.c_str(), width_, height_, 4, pixels.data(), width_ * 4)) {
+            std::cerr << "Error: Failed to write thumbnail " << filename << std::endl;
+            return false;
+        }
+        std::cout << "Thumbnail written to: " << filename << " (" << width_ << "x" << height_ << ", "
+                  << boxes_.size() << " boxes)" << std::endl;
+        return true;
+    }
+}
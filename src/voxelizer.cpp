@@ -4,9 +4,10 @@
 #include <iostream>
 #include <cmath>
 #include <map>
+#include <unordered_map>
 
 namespace obj2blocks {
-    Voxelizer::Voxelizer(double voxel_size) : voxel_size_(voxel_size) {
+    Voxelizer::Voxelizer(double voxel_size) : voxel_size_(voxel_size), alpha_cutoff_(0.0), alpha_culled_(0), profiler_(nullptr) {
     }
 
     Voxelizer::~Voxelizer() {
@@ -21,14 +22,19 @@ namespace obj2blocks {
     }
 
     std::set<Vec3i> Voxelizer::voxelize(pmp::SurfaceMesh&mesh, bool solid) {
-        std::cout << "Starting voxelization with voxel size: " << voxel_size_ << std::endl;
+        std::cout << "Starting voxelization with voxel size: " << voxel_size_ << '\n';
 
-        std::set<Vec3i> surface_voxels = voxelizeSurface(mesh);
-        std::cout << "Surface voxels: " << surface_voxels.size() << std::endl;
+        std::set<Vec3i> surface_voxels;
+        {
+            Profiler::Scope scope(profiler_, "surface_voxelize");
+            surface_voxels = voxelizeSurface(mesh);
+        }
+        std::cout << "Surface voxels: " << surface_voxels.size() << '\n';
 
         if (solid) {
+            Profiler::Scope scope(profiler_, "fill");
             std::set<Vec3i> filled_voxels = fillInterior(surface_voxels);
-            std::cout << "Total voxels after filling: " << filled_voxels.size() << std::endl;
+            std::cout << "Total voxels after filling: " << filled_voxels.size() << '\n';
             return filled_voxels;
         }
 
@@ -182,19 +188,29 @@ namespace obj2blocks {
     }
     
     std::set<VoxelData> Voxelizer::voxelizeWithMaterials(MeshProcessor& processor, bool solid) {
-        std::cout << "Starting voxelization with materials, voxel size: " << voxel_size_ << std::endl;
+        std::cout << "Starting voxelization with materials, voxel size: " << voxel_size_ << '\n';
         
-        std::set<VoxelData> surface_voxels = voxelizeSurfaceWithMaterials(processor);
-        std::cout << "Surface voxels with materials: " << surface_voxels.size() << std::endl;
+        std::set<VoxelData> surface_voxels;
+        {
+            Profiler::Scope scope(profiler_, "surface_voxelize");
+            surface_voxels = voxelizeSurfaceWithMaterials(processor);
+        }
+        std::cout << "Surface voxels with materials: " << surface_voxels.size() << '\n';
 
         if (solid) {
-            std::set<VoxelData> filled_voxels = fillInteriorWithColors(surface_voxels);
-            std::cout << "Total voxels after filling: " << filled_voxels.size() << std::endl;
+            std::set<VoxelData> filled_voxels;
+            {
+                Profiler::Scope scope(profiler_, "fill");
+                filled_voxels = fillInteriorWithColors(surface_voxels);
+            }
+            std::cout << "Total voxels after filling: " << filled_voxels.size() << '\n';
             // Ensure unique positions after filling
+            Profiler::Scope scope(profiler_, "dedupe");
             return dedupeByPositionAverage(filled_voxels);
         }
         
         // Ensure unique positions in surface-only mode as well
+        Profiler::Scope scope(profiler_, "dedupe");
         return dedupeByPositionAverage(surface_voxels);
     }
     
@@ -203,7 +219,7 @@ namespace obj2blocks {
         
         if (!processor.hasObjLoader()) {
             // Fall back to no materials
-            std::cout << "No material information available, using default color" << std::endl;
+            std::cout << "No material information available, using default color\n";
             auto simple_voxels = voxelizeSurface(processor.getMesh());
             for (const auto& v : simple_voxels) {
                 voxels.insert(VoxelData(v, Color4()));
@@ -214,6 +230,36 @@ namespace obj2blocks {
         auto& mesh = processor.getMesh();
         auto& obj_loader = processor.getObjLoader();
         auto points = mesh.vertex_property<pmp::Point>("v:point");
+        alpha_culled_ = 0;
+
+        if (obj_loader.hasVertexColors()) {
+            // Per-vertex colours: interpolate them directly, no materials or textures
+            std::cout << "Using per-vertex colors\n";
+            const auto& colors = obj_loader.getVertexColors();
+            for (auto f : mesh.faces()) {
+                pmp::Point corners[3];
+                Color4 corner_colors[3];
+                size_t count = 0;
+                for (auto v : mesh.vertices(f)) {
+                    if (count < 3) {
+                        corners[count] = points[v];
+                        corner_colors[count] = colors[v.idx()];
+                    }
+                    count++;
+                }
+                if (count == 3) {
+                    rasterizeTriangleWithVertexColors(corners[0], corners[1], corners[2], corner_colors[0],
+                                                      corner_colors[1], corner_colors[2], voxels);
+                }
+            }
+            return dedupeByPositionAverage(voxels);
+        }
+        
+        // Resolve each material's textures and flags once, not per sample
+        // Materials combining emissive or opacity maps sample a shared baked image
+        const MaterialLoader& material_loader = obj_loader.getMaterialLoader();
+        const MaterialSampler default_sampler;
+        std::unordered_map<const Material*, MaterialSampler> samplers;
         
         size_t face_idx = 0;
         for (auto f : mesh.faces()) {
@@ -228,13 +274,25 @@ namespace obj2blocks {
             }
             
             if (vertices.size() == 3) {
-                Material* material = obj_loader.getMaterialForFace(face_idx);
+                const Material* material = obj_loader.getMaterialForFace(face_idx);
+                const MaterialSampler* sampler = &default_sampler;
+                if (material) {
+                    auto it = samplers.find(material);
+                    if (it == samplers.end()) {
+                        it = samplers.emplace(material, material_loader.createSampler(*material)).first;
+                    }
+                    sampler = &it->second;
+                }
                 rasterizeTriangleWithMaterial(vertices[0], vertices[1], vertices[2],
-                                             uvs[0], uvs[1], uvs[2], material,
-                                             obj_loader.getMaterialLoader(), voxels);
+                                             uvs[0], uvs[1], uvs[2], *sampler, voxels);
             }
             face_idx++;
         }
+
+        if (alpha_cutoff_ > 0.0) {
+            std::cout << "Alpha cutoff " << alpha_cutoff_ << " dropped " << alpha_culled_
+                      << " triangle voxels\n";
+        }
         
         // Deduplicate by position across all triangles by averaging colors
         return dedupeByPositionAverage(voxels);
@@ -243,8 +301,41 @@ namespace obj2blocks {
     void Voxelizer::rasterizeTriangleWithMaterial(const pmp::Point&v0, const pmp::Point&v1,
                                                  const pmp::Point&v2, const Vec2f& uv0, 
                                                  const Vec2f& uv1, const Vec2f& uv2,
-                                                 Material* material, const MaterialLoader& mat_loader,
+                                                 const MaterialSampler& sampler,
                                                  std::set<VoxelData>&voxels) {
+        // Mip levels from the triangle's UV area per voxel face (level 0 without mipmaps)
+        pmp::Point world_cross = pmp::cross(v1 - v0, v2 - v0);
+        double world_area = 0.5 * pmp::norm(world_cross) / (voxel_size_ * voxel_size_);
+        double uv_area = 0.5 * std::abs((uv1.u - uv0.u) * (uv2.v - uv0.v) - (uv2.u - uv0.u) * (uv1.v - uv0.v));
+        const MaterialSampler::Levels levels =
+            sampler.levelsFor(world_area > 1e-12 ? static_cast<float>(uv_area / world_area) : 0.0f);
+
+        rasterizeTriangleColored(v0, v1, v2, [&](float w0, float w1, float w2) {
+            // Interpolate UV coordinates
+            float u = w0 * uv0.u + w1 * uv1.u + w2 * uv2.u;
+            float v = w0 * uv0.v + w1 * uv1.v + w2 * uv2.v;
+            return sampler.sample(u, v, levels);
+        }, voxels);
+    }
+
+    void Voxelizer::rasterizeTriangleWithVertexColors(const pmp::Point&v0, const pmp::Point&v1,
+                                                     const pmp::Point&v2, const Color4& c0,
+                                                     const Color4& c1, const Color4& c2,
+                                                     std::set<VoxelData>&voxels) {
+        rasterizeTriangleColored(v0, v1, v2, [&](float w0, float w1, float w2) {
+            auto mix = [&](uint8_t a, uint8_t b, uint8_t c) {
+                float value = w0 * a + w1 * b + w2 * c;
+                return static_cast<uint8_t>(std::clamp(std::lround(value), 0L, 255L));
+            };
+            return Color4(mix(c0.r, c1.r, c2.r), mix(c0.g, c1.g, c2.g),
+                          mix(c0.b, c1.b, c2.b), mix(c0.a, c1.a, c2.a));
+        }, voxels);
+    }
+
+    template <typename ColorAt>
+    void Voxelizer::rasterizeTriangleColored(const pmp::Point&v0, const pmp::Point&v1,
+                                            const pmp::Point&v2, const ColorAt& color_at,
+                                            std::set<VoxelData>&voxels) {
         Vec3i voxel0 = pointToVoxel(v0);
         Vec3i voxel1 = pointToVoxel(v1);
         Vec3i voxel2 = pointToVoxel(v2);
@@ -257,8 +348,10 @@ namespace obj2blocks {
         int max_z = std::max({voxel0.z, voxel1.z, voxel2.z});
         
         // 使用map来累积同一位置的颜色 - 只累积纹理采样的颜色
-        struct ColorAccum { double r=0, g=0, b=0, a=0; int count=0; };
+        // coverage/samples see every sample; r/g/b/a/count only those passing the alpha cutoff
+        struct ColorAccum { double r=0, g=0, b=0, a=0; int count=0; double coverage=0; int samples=0; };
         std::map<Vec3i, ColorAccum> color_accumulator;
+        const double alpha_threshold = alpha_cutoff_ * 255.0;
 
         for (int x = min_x; x <= max_x; ++x) {
             for (int y = min_y; y <= max_y; ++y) {
@@ -271,21 +364,17 @@ namespace obj2blocks {
                     
                     float w0, w1, w2;
                     if (computeBarycentricCoordinates(voxel_center, v0, v1, v2, w0, w1, w2)) {
-                        // Interpolate UV coordinates
-                        float u = w0 * uv0.u + w1 * uv1.u + w2 * uv2.u;
-                        float v = w0 * uv0.v + w1 * uv1.v + w2 * uv2.v;
-
                         // Get color from material - 优先使用纹理采样
-                        Color4 color;
-                        if (material) {
-                            color = mat_loader.calculateFinalColor(*material, u, v);
-                        } else {
-                            color = Color4();  // Default white
-                        }
+                        Color4 color = color_at(w0, w1, w2);
                         
                         // 累积颜色而不是直接插入
                         Vec3i pos(x, y, z);
                         auto& accum = color_accumulator[pos];
+                        accum.coverage += color.a;
+                        accum.samples++;
+                        if (color.a < alpha_threshold) {
+                            continue;
+                        }
                         accum.r += color.r;
                         accum.g += color.g;
                         accum.b += color.b;
@@ -300,25 +389,21 @@ namespace obj2blocks {
         // 但是只在没有其他采样点时才使用材质的默认diffuse颜色
         for (const Vec3i& vertex_pos : {voxel0, voxel1, voxel2}) {
           if (color_accumulator.find(vertex_pos) == color_accumulator.end()) {
-            // 这个顶点位置没有被三角形内部的采样覆盖，使用材质默认颜色
+            // 这个顶点位置没有被三角形内部的采样覆盖，使用顶点处的颜色
             Color4 vertex_color;
-            if (material) {
-              // 对于顶点，我们也尝试使用对应的UV坐标进行纹理采样
-              Vec2f vertex_uv;
-              if (vertex_pos == voxel0)
-                vertex_uv = uv0;
-              else if (vertex_pos == voxel1)
-                vertex_uv = uv1;
-              else
-                vertex_uv = uv2;
-
-              vertex_color = mat_loader.calculateFinalColor(
-                  *material, vertex_uv.u, vertex_uv.v);
-            } else {
-              vertex_color = Color4();
-            }
+            if (vertex_pos == voxel0)
+              vertex_color = color_at(1.0f, 0.0f, 0.0f);
+            else if (vertex_pos == voxel1)
+              vertex_color = color_at(0.0f, 1.0f, 0.0f);
+            else
+              vertex_color = color_at(0.0f, 0.0f, 1.0f);
 
             auto &accum = color_accumulator[vertex_pos];
+            accum.coverage += vertex_color.a;
+            accum.samples++;
+            if (vertex_color.a < alpha_threshold) {
+              continue;
+            }
             accum.r += vertex_color.r;
             accum.g += vertex_color.g;
             accum.b += vertex_color.b;
@@ -331,6 +416,11 @@ namespace obj2blocks {
         for (const auto& kv : color_accumulator) {
             const Vec3i& pos = kv.first;
             const ColorAccum& accum = kv.second;
+            // Cut-out texels: nothing opaque enough landed here, or too little of the voxel is covered
+            if (accum.count == 0 || accum.coverage < alpha_threshold * accum.samples) {
+                alpha_culled_++;
+                continue;
+            }
             Color4 avg_color(
                 static_cast<uint8_t>(std::round(accum.r / std::max(1, accum.count))),
                 static_cast<uint8_t>(std::round(accum.g / std::max(1, accum.count))),